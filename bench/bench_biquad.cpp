@@ -0,0 +1,71 @@
+#include "dsp/biquad.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#else
+#define BENCH_HAS_TSC 0
+#endif
+
+/**
+ * Cost of filtering the three axes of a sensor sample with biquad cascades
+ * of increasing length, reported in nanoseconds and, on x86, in TSC cycles
+ * per sample
+ */
+
+using namespace mp;
+
+static constexpr size_t MAX_SECTIONS = 4;
+static constexpr size_t BLOCK_SIZE = 64;
+static constexpr size_t BLOCK_COUNT = 20000;
+static constexpr float SAMPLE_RATE = 8000.f;
+
+// Keeps the filtered output alive
+static volatile float g_sink;
+
+static uint64_t read_cycles() noexcept
+{
+#if BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+int main()
+{
+    // Some noise, generated once so the generator isn't measured
+    static float input[BLOCK_SIZE][3];
+    for (size_t i = 0; i < BLOCK_SIZE; i++)
+        for (size_t j = 0; j < 3; j++)
+            input[i][j] = static_cast<float>(rand()) / RAND_MAX - 0.5f;
+
+    printf("sections  ns/sample  cycles/sample\n");
+    for (size_t sections = 1; sections <= MAX_SECTIONS; sections++) {
+        biquad_cascade3<MAX_SECTIONS> filter;
+        for (size_t i = 0; i < sections; i++)
+            filter.set_section(i, biquad_lowpass(SAMPLE_RATE, 100.f * (i + 1)));
+
+        float block[BLOCK_SIZE][3];
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t start_cycles = read_cycles();
+        for (size_t n = 0; n < BLOCK_COUNT; n++) {
+            for (size_t i = 0; i < BLOCK_SIZE; i++)
+                for (size_t j = 0; j < 3; j++)
+                    block[i][j] = input[i][j];
+            filter.process(block, BLOCK_SIZE);
+            g_sink = block[n % BLOCK_SIZE][n % 3];
+        }
+        const uint64_t cycles = read_cycles() - start_cycles;
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        const double samples = static_cast<double>(BLOCK_SIZE) * BLOCK_COUNT;
+        const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        printf("%8zu  %9.2f  %13.2f\n", sections, ns / samples, cycles / samples);
+    }
+    if (!BENCH_HAS_TSC)
+        printf("Cycle counter not available on this architecture\n");
+    return 0;
+}
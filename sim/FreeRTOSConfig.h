@@ -0,0 +1,74 @@
+#pragma once
+
+// FreeRTOS configuration for the POSIX port used by the simulation,
+// every task runs as a pthread and the tick comes from a host timer.
+// With MP_SIM_VIRTUAL_TIME the port in virtual_time is used instead,
+// where the idle task advances the tick and the tasks keep their host
+// stacks outside of the FreeRTOS ones.
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configUSE_TICKLESS_IDLE                 0
+#define configCPU_CLOCK_HZ                      1000000
+// Matches EMBLIB_RTOS_TICK_MILLIS
+#define configTICK_RATE_HZ                      1000
+// Minipilot priorities go up to 5, and the simulation task is above them
+#define configMAX_PRIORITIES                    7
+#if MP_SIM_VIRTUAL_TIME
+#define configMINIMAL_STACK_SIZE                64
+#else
+#define configMINIMAL_STACK_SIZE                PTHREAD_STACK_MIN
+#endif
+#define configMAX_TASK_NAME_LEN                 24
+#define configTICK_TYPE_WIDTH_IN_BITS           TICK_TYPE_WIDTH_32_BITS
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   1
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             1
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configQUEUE_REGISTRY_SIZE               0
+#define configUSE_QUEUE_SETS                    0
+#define configUSE_TIME_SLICING                  1
+#define configUSE_NEWLIB_REENTRANT              0
+#define configENABLE_BACKWARD_COMPATIBILITY     1
+
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configKERNEL_PROVIDED_STATIC_MEMORY     1
+#define configTOTAL_HEAP_SIZE                   (256 * 1024)
+#define configAPPLICATION_ALLOCATED_HEAP        0
+
+#if MP_SIM_VIRTUAL_TIME
+// Advances the virtual time, defined by the port
+#define configUSE_IDLE_HOOK                     1
+#else
+#define configUSE_IDLE_HOOK                     0
+#endif
+#define configUSE_TICK_HOOK                     0
+#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configUSE_DAEMON_TASK_STARTUP_HOOK      0
+
+#define configGENERATE_RUN_TIME_STATS           0
+#define configUSE_TRACE_FACILITY                0
+#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+
+#define configUSE_CO_ROUTINES                   0
+#define configUSE_TIMERS                        1
+#define configTIMER_TASK_PRIORITY               (configMAX_PRIORITIES - 1)
+#define configTIMER_QUEUE_LENGTH                8
+#define configTIMER_TASK_STACK_DEPTH            configMINIMAL_STACK_SIZE
+
+#define INCLUDE_vTaskPrioritySet                1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_vTaskDelete                     1
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_xTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+
+#include <limits.h>
+#include <assert.h>
+#define configASSERT(x)                         assert(x)
@@ -0,0 +1,99 @@
+#include "shm_link.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mp::sim {
+
+shm_link::~shm_link() noexcept
+{
+    close();
+}
+
+void shm_link::close() noexcept
+{
+    if (m_header)
+        munmap(m_header, m_size);
+    if (m_name[0])
+        shm_unlink(m_name);
+    m_header = nullptr;
+    m_to_peer = nullptr;
+    m_from_peer = nullptr;
+    m_name[0] = '\0';
+}
+
+bool shm_link::create(const char* name, uint32_t capacity) noexcept
+{
+    if (m_header || !shm_ring::is_valid_capacity(capacity) || strlen(name) >= sizeof(m_name))
+        return false;
+
+    shm_unlink(name);
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        return false;
+
+    const size_t size = get_size(capacity);
+    if (ftruncate(fd, size) < 0 || !map(fd, size)) {
+        ::close(fd);
+        shm_unlink(name);
+        return false;
+    }
+    ::close(fd);
+    strcpy(m_name, name);
+
+    m_side = side_e::MINIPILOT;
+    m_header->capacity = capacity;
+    locate_rings(capacity);
+    m_to_peer->init(capacity);
+    m_from_peer->init(capacity);
+    // Peer only uses the rings once it sees the magic
+    m_header->magic.store(MAGIC, std::memory_order_release);
+    return true;
+}
+
+bool shm_link::open(const char* name) noexcept
+{
+    if (m_header)
+        return false;
+
+    const int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(header_s) || !map(fd, st.st_size)) {
+        ::close(fd);
+        return false;
+    }
+    ::close(fd);
+
+    m_side = side_e::PEER;
+    if (m_header->magic.load(std::memory_order_acquire) != MAGIC || m_size < get_size(m_header->capacity)) {
+        munmap(m_header, m_size);
+        m_header = nullptr;
+        return false;
+    }
+    locate_rings(m_header->capacity);
+    return true;
+}
+
+bool shm_link::map(int fd, size_t size) noexcept
+{
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+        return false;
+
+    m_header = static_cast<header_s*>(memory);
+    m_size = size;
+    return true;
+}
+
+void shm_link::locate_rings(uint32_t capacity) noexcept
+{
+    char* memory = reinterpret_cast<char*>(m_header);
+    m_to_peer = reinterpret_cast<shm_ring*>(memory + get_ring_offset(capacity, 0));
+    m_from_peer = reinterpret_cast<shm_ring*>(memory + get_ring_offset(capacity, 1));
+}
+
+}
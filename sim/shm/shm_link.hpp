@@ -0,0 +1,110 @@
+#pragma once
+
+#include "shm_ring.hpp"
+
+namespace mp::sim {
+
+/**
+ * Bidirectional link between minipilot and a peer process (simulator,
+ * ground station) over two rings in a POSIX shared memory object
+ *
+ * Minipilot creates the object, which the peer then opens by name, so the
+ * data of every message crosses the link with a single copy into the ring
+ * and a single copy out of it, without any system calls. Neither side
+ * blocks, so the reader polls for the data at its own rate.
+ *
+ * Layout of the object: header, ring from minipilot to the peer, ring
+ * from the peer to minipilot, each ring followed by its data.
+ */
+class shm_link {
+
+public:
+    // Identifies an initialized object, "MPSL"
+    static constexpr uint32_t MAGIC = 0x4C53504D;
+    static constexpr uint32_t DEFAULT_CAPACITY = 64 * 1024;
+
+    enum class side_e {
+        MINIPILOT,
+        PEER
+    };
+
+    shm_link() noexcept = default;
+    ~shm_link() noexcept;
+
+    shm_link(const shm_link&) = delete;
+    shm_link& operator=(const shm_link&) = delete;
+
+    /**
+     * Create the object, replacing an existing one with the same name
+     * @param name Name of the object, starting with '/'
+     * @param capacity Capacity of each ring, a power of two
+     */
+    bool create(const char* name, uint32_t capacity = DEFAULT_CAPACITY) noexcept;
+
+    /**
+     * Open the object created by the minipilot side
+     * @returns false if it doesn't exist or isn't initialized yet
+     */
+    bool open(const char* name) noexcept;
+
+    /**
+     * Unmap the object, and remove it if this side created it
+     * @note Done by the destructor, but processes ending with `_exit` must call it
+     */
+    void close() noexcept;
+
+    /**
+     * Ring written by this side
+     */
+    shm_ring& get_tx() noexcept
+    {
+        return m_side == side_e::MINIPILOT ? *m_to_peer : *m_from_peer;
+    }
+
+    /**
+     * Ring read by this side
+     */
+    shm_ring& get_rx() noexcept
+    {
+        return m_side == side_e::MINIPILOT ? *m_from_peer : *m_to_peer;
+    }
+
+    bool is_open() const noexcept
+    {
+        return m_header != nullptr;
+    }
+
+private:
+    struct header_s {
+        std::atomic<uint32_t> magic;
+        uint32_t capacity;
+    };
+
+    static size_t get_size(uint32_t capacity) noexcept
+    {
+        return get_ring_offset(capacity, 2);
+    }
+
+    static size_t get_ring_offset(uint32_t capacity, size_t index) noexcept
+    {
+        // Rings stay aligned to the cache line
+        const size_t header_size = (sizeof(header_s) + SHM_CACHE_LINE_SIZE - 1) & ~(SHM_CACHE_LINE_SIZE - 1);
+        const size_t ring_size = (shm_ring::get_footprint(capacity) + SHM_CACHE_LINE_SIZE - 1) & ~(SHM_CACHE_LINE_SIZE - 1);
+        return header_size + index * ring_size;
+    }
+
+    bool map(int fd, size_t size) noexcept;
+
+    void locate_rings(uint32_t capacity) noexcept;
+
+private:
+    side_e m_side = side_e::MINIPILOT;
+    header_s* m_header = nullptr;
+    shm_ring* m_to_peer = nullptr;
+    shm_ring* m_from_peer = nullptr;
+    size_t m_size = 0;
+    // Set only on the side which created the object, which removes it
+    char m_name[64] = {};
+};
+
+}
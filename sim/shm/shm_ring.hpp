@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace mp::sim {
+
+// Head and tail are kept on separate cache lines so the two sides don't share one
+inline constexpr size_t SHM_CACHE_LINE_SIZE = 64;
+
+/**
+ * Lock-free single producer single consumer byte ring, placed in
+ * memory shared by two processes with the data right after it
+ *
+ * Head and tail are free running counters, so the capacity is a power of
+ * two and the ring is full when they differ by the capacity. The producer
+ * only writes the head and the consumer only writes the tail, publishing
+ * the data with a release store which the other side reads with acquire.
+ */
+class shm_ring {
+
+public:
+    /**
+     * Bytes needed for a ring of the capacity, including the data
+     */
+    static constexpr size_t get_footprint(uint32_t capacity) noexcept
+    {
+        return sizeof(shm_ring) + capacity;
+    }
+
+    static constexpr bool is_valid_capacity(uint32_t capacity) noexcept
+    {
+        return capacity > 0 && (capacity & (capacity - 1)) == 0;
+    }
+
+    /**
+     * Initialize the ring in place, done once by the creator of the memory
+     */
+    void init(uint32_t capacity) noexcept
+    {
+        m_capacity = capacity;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * Copy all of the data or nothing if it doesn't fit, so that a message
+     * is never split and the reader sees it whole, called only by the producer
+     * @returns Number of bytes written, 0 if the data doesn't fit
+     */
+    size_t write(const char* data, size_t size) noexcept
+    {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        const uint32_t tail = m_tail.load(std::memory_order_acquire);
+        const size_t free = m_capacity - (head - tail);
+        if (size > free)
+            return 0;
+
+        copy_in(head & (m_capacity - 1), data, size);
+        m_head.store(head + static_cast<uint32_t>(size), std::memory_order_release);
+        return size;
+    }
+
+    /**
+     * Copy out as much data as is available, called only by the consumer
+     * @returns Number of bytes read
+     */
+    size_t read(char* buffer, size_t size) noexcept
+    {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint32_t head = m_head.load(std::memory_order_acquire);
+        const size_t available = head - tail;
+        if (size > available)
+            size = available;
+
+        copy_out(tail & (m_capacity - 1), buffer, size);
+        m_tail.store(tail + static_cast<uint32_t>(size), std::memory_order_release);
+        return size;
+    }
+
+    /**
+     * Bytes waiting to be read
+     */
+    size_t get_available() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t get_capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+private:
+    char* get_data() noexcept
+    {
+        return reinterpret_cast<char*>(this + 1);
+    }
+
+    void copy_in(uint32_t offset, const char* data, size_t size) noexcept
+    {
+        const size_t first = size < m_capacity - offset ? size : m_capacity - offset;
+        memcpy(get_data() + offset, data, first);
+        memcpy(get_data(), data + first, size - first);
+    }
+
+    void copy_out(uint32_t offset, char* buffer, size_t size) noexcept
+    {
+        const size_t first = size < m_capacity - offset ? size : m_capacity - offset;
+        memcpy(buffer, get_data() + offset, first);
+        memcpy(buffer + first, get_data(), size - first);
+    }
+
+private:
+    alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint32_t> m_head;
+    alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint32_t> m_tail;
+    // Written once before the ring is shared
+    alignas(SHM_CACHE_LINE_SIZE) uint32_t m_capacity;
+};
+
+// Shared between processes, so the atomics can't rely on a lock
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Ring counters must be lock-free");
+
+}
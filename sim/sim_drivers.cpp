@@ -0,0 +1,132 @@
+#include "sim_drivers.hpp"
+#include "util/constants.hpp"
+#include <cerrno>
+#include <unistd.h>
+
+namespace mp::sim {
+
+void sensor_fifo::push(const float (&data)[3]) noexcept
+{
+    emblib::scoped_lock lock(m_mutex);
+    const size_t tail = (m_head + m_count) % CAPACITY;
+    for (size_t i = 0; i < 3; i++)
+        m_samples[tail][i] = data[i];
+
+    if (m_count < CAPACITY)
+        m_count++;
+    else
+        m_head = (m_head + 1) % CAPACITY;
+}
+
+size_t sensor_fifo::pop(float (*data)[3], size_t max_count, size_t& remaining_count) noexcept
+{
+    emblib::scoped_lock lock(m_mutex);
+    const size_t count = m_count < max_count ? m_count : max_count;
+    for (size_t j = 0; j < count; j++) {
+        for (size_t i = 0; i < 3; i++)
+            data[j][i] = m_samples[m_head][i];
+        m_head = (m_head + 1) % CAPACITY;
+    }
+    m_count -= count;
+    remaining_count = m_count;
+    return count;
+}
+
+void accelerometer::measure(const truth_s& truth, float (&data)[3]) noexcept
+{
+    // Specific force, what the accelerometer feels, in the local frame
+    const vector3f force = truth.rotationq.conjugate().rotate_vec(truth.acceleration - GV);
+    for (size_t i = 0; i < 3; i++)
+        data[i] = force(i) + m_noise(m_generator);
+}
+
+void gyroscope::measure(const truth_s& truth, float (&data)[3]) noexcept
+{
+    for (size_t i = 0; i < 3; i++)
+        data[i] = truth.angular_velocity(i) + m_noise(m_generator);
+}
+
+ssize_t posix_char_dev::write(const char* data, size_t size, emblib::milliseconds timeout) noexcept
+{
+    size_t written = 0;
+    while (written < size) {
+        const ssize_t status = ::write(m_fd, data + written, size - written);
+        // Interrupted by the signals of the scheduler
+        if (status < 0 && errno == EINTR)
+            continue;
+        if (status < 0)
+            return written > 0 ? static_cast<ssize_t>(written) : -1;
+        written += status;
+    }
+    return static_cast<ssize_t>(written);
+}
+
+ssize_t posix_char_dev::read(char* buffer, size_t size, emblib::milliseconds timeout) noexcept
+{
+    ssize_t status;
+    do {
+        status = ::read(m_fd, buffer, size);
+    } while (status < 0 && errno == EINTR);
+
+    if (status < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    return status;
+}
+
+bool polled_char_dev::write_async(const char* data, size_t size, const callback_t& callback) noexcept
+{
+    if (m_write_pending.load(std::memory_order_acquire))
+        return false;
+
+    const ssize_t status = write(data, size);
+    if (status < 0 || static_cast<size_t>(status) == size) {
+        callback(status);
+        return true;
+    }
+
+    m_write_data = data;
+    m_write_size = size;
+    m_write_offset = static_cast<size_t>(status);
+    m_write_callback = callback;
+    m_write_pending.store(true, std::memory_order_release);
+    return true;
+}
+
+bool polled_char_dev::read_async(char* buffer, size_t size, const callback_t& callback) noexcept
+{
+    if (m_read_pending.load(std::memory_order_acquire))
+        return false;
+
+    m_read_buffer = buffer;
+    m_read_size = size;
+    m_read_callback = callback;
+    m_read_pending.store(true, std::memory_order_release);
+    return true;
+}
+
+void polled_char_dev::poll() noexcept
+{
+    if (m_write_pending.load(std::memory_order_acquire)) {
+        const ssize_t status = write(m_write_data + m_write_offset, m_write_size - m_write_offset);
+        if (status > 0)
+            m_write_offset += static_cast<size_t>(status);
+
+        if (status < 0 || m_write_offset == m_write_size) {
+            // Callback can start the next transfer
+            callback_t callback = std::move(m_write_callback);
+            m_write_pending.store(false, std::memory_order_release);
+            callback(status < 0 ? status : static_cast<ssize_t>(m_write_size));
+        }
+    }
+
+    if (m_read_pending.load(std::memory_order_acquire)) {
+        const ssize_t status = read(m_read_buffer, m_read_size);
+        if (status != 0) {
+            callback_t callback = std::move(m_read_callback);
+            m_read_pending.store(false, std::memory_order_release);
+            callback(status);
+        }
+    }
+}
+
+}
@@ -0,0 +1,405 @@
+#pragma once
+
+#include "sim_model.hpp"
+#include "shm/shm_ring.hpp"
+#include "drivers/imu.hpp"
+#include "drivers/three_axis_fifo.hpp"
+#include <emblib/driver/accelerometer.hpp>
+#include <emblib/driver/char_dev.hpp>
+#include <emblib/driver/gyroscope.hpp>
+#include <emblib/driver/motor.hpp>
+#include <emblib/rtos/mutex.hpp>
+#include <atomic>
+#include <cmath>
+#include <random>
+
+namespace mp::sim {
+
+/**
+ * Sample FIFO of a simulated sensor, which drops the oldest
+ * samples when it is full like the FIFO of the chip would
+ */
+class sensor_fifo {
+
+public:
+    void push(const float (&data)[3]) noexcept;
+
+    /**
+     * @param remaining_count Set to the number of samples left
+     * @returns Number of the oldest samples moved to `data`
+     */
+    size_t pop(float (*data)[3], size_t max_count, size_t& remaining_count) noexcept;
+
+private:
+    // Around 4 periods of the sensor tasks at the physics rate
+    static constexpr size_t CAPACITY = 32;
+
+    emblib::mutex m_mutex;
+    float m_samples[CAPACITY][3];
+    size_t m_head = 0;
+    size_t m_count = 0;
+};
+
+/**
+ * Accelerometer measuring the specific force of the model in the local frame
+ *
+ * Samples are also buffered in a FIFO by `sample`, which
+ * should be called at the output data rate.
+ */
+class accelerometer : public emblib::accelerometer, public three_axis_fifo<float> {
+
+public:
+    /**
+     * @param noise_density In m/s^2/sqrt(Hz)
+     * @param sample_rate Rate at which the sensor is sampled in Hz, sets the noise of a sample
+     */
+    explicit accelerometer(model& model, float noise_density, float sample_rate) noexcept :
+        m_model(model),
+        m_noise_density(noise_density),
+        m_sample_rate(sample_rate),
+        m_noise(0.f, noise_density * std::sqrt(sample_rate))
+    {}
+
+    /**
+     * Add a sample to the FIFO
+     */
+    void sample() noexcept
+    {
+        float data[3];
+        read_all_axes(data);
+        m_fifo.push(data);
+    }
+
+    bool probe() noexcept override
+    {
+        return true;
+    }
+
+    bool read_all_axes(float (&data)[3]) noexcept override
+    {
+        measure(m_model.get_truth(), data);
+        return true;
+    }
+
+    /**
+     * Measure the given state, with a new noise sample
+     */
+    void measure(const truth_s& truth, float (&data)[3]) noexcept;
+
+    float get_noise_density() const noexcept override
+    {
+        return m_noise_density;
+    }
+
+    bool read_fifo(float (*data)[3], size_t max_count, size_t& read_count, size_t& remaining_count) noexcept override
+    {
+        read_count = m_fifo.pop(data, max_count, remaining_count);
+        return true;
+    }
+
+    float get_output_data_rate() const noexcept override
+    {
+        return m_sample_rate;
+    }
+
+private:
+    model& m_model;
+    float m_noise_density;
+    float m_sample_rate;
+    std::mt19937 m_generator;
+    std::normal_distribution<float> m_noise;
+    sensor_fifo m_fifo;
+};
+
+/**
+ * Gyroscope measuring the angular velocity of the model in the local frame
+ *
+ * Samples are also buffered in a FIFO by `sample`, which
+ * should be called at the output data rate.
+ */
+class gyroscope : public emblib::gyroscope, public three_axis_fifo<float> {
+
+public:
+    /**
+     * @param noise_density In rad/s/sqrt(Hz)
+     * @param sample_rate Rate at which the sensor is sampled in Hz, sets the noise of a sample
+     */
+    explicit gyroscope(model& model, float noise_density, float sample_rate) noexcept :
+        m_model(model),
+        m_noise_density(noise_density),
+        m_sample_rate(sample_rate),
+        m_noise(0.f, noise_density * std::sqrt(sample_rate))
+    {}
+
+    /**
+     * Add a sample to the FIFO
+     */
+    void sample() noexcept
+    {
+        float data[3];
+        read_all_axes(data);
+        m_fifo.push(data);
+    }
+
+    bool probe() noexcept override
+    {
+        return true;
+    }
+
+    bool read_all_axes(float (&data)[3]) noexcept override
+    {
+        measure(m_model.get_truth(), data);
+        return true;
+    }
+
+    /**
+     * Measure the given state, with a new noise sample
+     */
+    void measure(const truth_s& truth, float (&data)[3]) noexcept;
+
+    float get_noise_density() const noexcept override
+    {
+        return m_noise_density;
+    }
+
+    bool read_fifo(float (*data)[3], size_t max_count, size_t& read_count, size_t& remaining_count) noexcept override
+    {
+        read_count = m_fifo.pop(data, max_count, remaining_count);
+        return true;
+    }
+
+    float get_output_data_rate() const noexcept override
+    {
+        return m_sample_rate;
+    }
+
+private:
+    model& m_model;
+    float m_noise_density;
+    float m_sample_rate;
+    std::mt19937 m_generator;
+    std::normal_distribution<float> m_noise;
+    sensor_fifo m_fifo;
+};
+
+/**
+ * IMU made of the simulated accelerometer and gyroscope, which measure
+ * the same state of the model
+ *
+ * Data ready is signaled by `tick`, which should be called after every
+ * physics step, every `steps_per_sample` steps.
+ */
+class imu : public mp::imu {
+
+public:
+    explicit imu(model& model, accelerometer& accelerometer, gyroscope& gyroscope, float physics_rate, size_t steps_per_sample) noexcept :
+        m_model(model),
+        m_accelerometer(accelerometer),
+        m_gyroscope(gyroscope),
+        m_output_data_rate(physics_rate / steps_per_sample),
+        m_steps_per_sample(steps_per_sample),
+        m_step(0),
+        m_callback_set(false)
+    {}
+
+    bool read_imu(float (&accelerometer)[3], float (&gyroscope)[3]) noexcept override
+    {
+        const truth_s truth = m_model.get_truth();
+        m_accelerometer.measure(truth, accelerometer);
+        m_gyroscope.measure(truth, gyroscope);
+        return true;
+    }
+
+    float get_output_data_rate() const noexcept override
+    {
+        return m_output_data_rate;
+    }
+
+    bool has_data_ready() const noexcept override
+    {
+        return true;
+    }
+
+    bool set_data_ready_callback(const callback_t& callback) noexcept override
+    {
+        m_callback = callback;
+        m_callback_set.store(true, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Advance by a physics step, signals data ready once a sample is due
+     */
+    void tick() noexcept
+    {
+        if (++m_step < m_steps_per_sample)
+            return;
+        m_step = 0;
+        if (m_callback_set.load(std::memory_order_acquire))
+            m_callback();
+    }
+
+private:
+    model& m_model;
+    accelerometer& m_accelerometer;
+    gyroscope& m_gyroscope;
+    float m_output_data_rate;
+    size_t m_steps_per_sample;
+    size_t m_step;
+    callback_t m_callback;
+    std::atomic<bool> m_callback_set;
+};
+
+/**
+ * Motor which responds to the throttle immediately
+ */
+class motor : public emblib::motor {
+
+public:
+    /**
+     * @param ccw Is the rotation counter clockwise when seen from above
+     */
+    explicit motor(bool ccw) noexcept :
+        m_ccw(ccw),
+        m_throttle(0.f)
+    {}
+
+    bool write_throttle(float throttle) noexcept override
+    {
+        m_throttle.store(throttle < 0.f ? 0.f : throttle > 1.f ? 1.f : throttle);
+        return true;
+    }
+
+    bool read_throttle(float& throttle) const noexcept override
+    {
+        throttle = m_throttle.load();
+        return true;
+    }
+
+    bool get_direction() const noexcept override
+    {
+        return m_ccw;
+    }
+
+private:
+    bool m_ccw;
+    std::atomic<float> m_throttle;
+};
+
+/**
+ * Character device whose async transfers are completed by polling
+ *
+ * Async reads only record the request, which is completed with the
+ * synchronous `read` of the subclass by `poll` from the simulation task,
+ * so that the callbacks run in a task like they would in an interrupt on
+ * the target. A pending read completes once there is any data.
+ *
+ * Async writes are tried right away and complete inline if the device
+ * takes all the data, so they don't wait for the next poll, which would
+ * add a whole simulation period to the latency of every message. Whatever
+ * isn't taken stays pending and `poll` retries it until it's all written.
+ */
+class polled_char_dev : public emblib::char_dev {
+
+public:
+    polled_char_dev() noexcept :
+        m_write_offset(0),
+        m_write_pending(false),
+        m_read_pending(false)
+    {}
+
+    bool is_async_available() noexcept override
+    {
+        return true;
+    }
+
+    bool write_async(const char* data, size_t size, const callback_t& callback) noexcept override;
+
+    bool read_async(char* buffer, size_t size, const callback_t& callback) noexcept override;
+
+    /**
+     * Complete the pending async transfers
+     */
+    void poll() noexcept;
+
+private:
+    const char* m_write_data;
+    size_t m_write_size;
+    size_t m_write_offset;
+    callback_t m_write_callback;
+    std::atomic<bool> m_write_pending;
+
+    char* m_read_buffer;
+    size_t m_read_size;
+    callback_t m_read_callback;
+    std::atomic<bool> m_read_pending;
+};
+
+/**
+ * Character device over a POSIX file descriptor
+ *
+ * Synchronous reads and writes go straight to the file descriptor,
+ * the end of a file is treated as no data.
+ */
+class posix_char_dev : public polled_char_dev {
+
+public:
+    /**
+     * @note The file descriptor should be non-blocking for reading
+     */
+    explicit posix_char_dev(int fd) noexcept :
+        m_fd(fd)
+    {}
+
+    ssize_t write(const char* data, size_t size, emblib::milliseconds timeout = emblib::milliseconds(0)) noexcept override;
+
+    ssize_t read(char* buffer, size_t size, emblib::milliseconds timeout = emblib::milliseconds(0)) noexcept override;
+
+    bool probe(emblib::milliseconds timeout = emblib::milliseconds(0)) noexcept override
+    {
+        return m_fd >= 0;
+    }
+
+private:
+    int m_fd;
+};
+
+/**
+ * Character device over the rings of a shared memory link, see `shm_link`
+ *
+ * Writes copy the data into the transmit ring only if all of it fits, and
+ * reads take what is in the receive ring, so nothing blocks. A write which
+ * doesn't fit returns 0, async writes stay pending until the peer makes room.
+ */
+class shm_char_dev : public polled_char_dev {
+
+public:
+    /**
+     * @note Without the rings the device is not available
+     */
+    explicit shm_char_dev(shm_ring* tx, shm_ring* rx) noexcept :
+        m_tx(tx),
+        m_rx(rx)
+    {}
+
+    ssize_t write(const char* data, size_t size, emblib::milliseconds timeout = emblib::milliseconds(0)) noexcept override
+    {
+        return m_tx->write(data, size);
+    }
+
+    ssize_t read(char* buffer, size_t size, emblib::milliseconds timeout = emblib::milliseconds(0)) noexcept override
+    {
+        return m_rx->read(buffer, size);
+    }
+
+    bool probe(emblib::milliseconds timeout = emblib::milliseconds(0)) noexcept override
+    {
+        return m_tx && m_rx;
+    }
+
+private:
+    shm_ring* m_tx;
+    shm_ring* m_rx;
+};
+
+}
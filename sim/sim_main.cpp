@@ -0,0 +1,408 @@
+#include "sim_drivers.hpp"
+#include "sim_model.hpp"
+#include "shm/shm_link.hpp"
+#include "flight_stack.hpp"
+#include "state/ekf_inertial.hpp"
+#include "tasks/task.hpp"
+#include "tasks/task_config.hpp"
+#include "vehicles/copter/quadcopter.hpp"
+#include "vehicles/copter/control/copter_controller_pid.hpp"
+#include "util/logger.hpp"
+#include <emblib/rtos/task.hpp>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#if MP_SIM_VIRTUAL_TIME
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+namespace mp::sim {
+
+// Physics step, also the rate at which the async transfers complete
+inline constexpr auto SIM_PERIOD = std::chrono::milliseconds(1);
+inline constexpr float SIM_DT = std::chrono::duration<float>(SIM_PERIOD).count();
+// Above all the minipilot tasks, like the hardware it replaces
+inline constexpr auto SIM_PRIORITY = static_cast<task_priority_e>(TASK_PRIORITY_REALTIME + 1);
+// Time given to the logger to send the reports before exiting
+inline constexpr auto SIM_LOG_DRAIN_TIME = std::chrono::milliseconds(200);
+
+// Sensor noise densities, in the range of common MEMS sensors
+inline constexpr float SIM_ACCEL_NOISE_DENSITY = 2e-3f; // m/s^2/sqrt(Hz)
+inline constexpr float SIM_GYRO_NOISE_DENSITY = 1e-4f; // rad/s/sqrt(Hz)
+
+/**
+ * Command line options of the simulation
+ */
+struct options_s {
+    // Simulated time in seconds, 0 runs forever
+    float duration = 10.f;
+    // Independent vehicles in the process, more than one needs MP_MULTI_INSTANCE
+    size_t vehicle_count = 1;
+    // Frames sent by the transmitter, telemetry is disabled if not set,
+    // with multiple vehicles the index of the vehicle is appended
+    const char* telemetry_path = nullptr;
+    // Command frames received by the first vehicle, can be a FIFO
+    const char* commands_path = "/dev/null";
+    // Chrome trace JSON of the first vehicle written at the end, needs MP_TRACE
+    const char* trace_path = nullptr;
+    // Shared memory link which replaces the telemetry and command files of the first vehicle
+    const char* link_name = nullptr;
+    // Read single sensor samples at the task rates instead of the FIFOs filled at the physics rate
+    bool polled_sensors = false;
+    // Read both sensors as an IMU on its data ready signal, at the rate of the gyroscope task
+    bool imu = false;
+};
+
+/**
+ * Quadcopter with the simulated motors, which need no initialization
+ */
+class sim_quadcopter : public quadcopter {
+
+public:
+    using quadcopter::quadcopter;
+
+    bool init() noexcept override
+    {
+        return true;
+    }
+};
+
+/**
+ * Flight context of a simulated vehicle, a base so that it is
+ * created and made current before any module of the vehicle
+ */
+class sim_vehicle_context {
+
+public:
+    sim_vehicle_context() noexcept
+    {
+        flight_context::set_current(&m_context);
+    }
+
+protected:
+    flight_context m_context;
+};
+
+/**
+ * Simulated vehicle with its own flight stack
+ *
+ * Modules register with the parameters of the context which is current
+ * when they are created, which is the one of this vehicle.
+ */
+class sim_vehicle : private sim_vehicle_context {
+
+public:
+    /**
+     * @param link Carries the telemetry and commands if not `nullptr`
+     */
+    explicit sim_vehicle(const quadcopter_params_s& params, const options_s& options, size_t index, shm_link* link) noexcept :
+        // Diagonal motors spin the same way
+        m_motor_fl(true),
+        m_motor_fr(false),
+        m_motor_bl(false),
+        m_motor_br(true),
+        m_controller(params),
+        m_quad(params, m_controller, {m_motor_fl, m_motor_fr, m_motor_bl, m_motor_br}),
+        m_estimator(m_quad),
+        m_model(m_quad),
+        m_accel(m_model, SIM_ACCEL_NOISE_DENSITY, get_sensor_rate(options)),
+        m_gyro(m_model, SIM_GYRO_NOISE_DENSITY, get_sensor_rate(options)),
+        m_sample_sensors(!options.polled_sensors && !options.imu),
+        m_imu(m_model, m_accel, m_gyro, 1.f / SIM_DT, TASK_GYRO_PERIOD / SIM_PERIOD),
+        m_use_imu(options.imu),
+        m_log_device(STDOUT_FILENO),
+        m_receiver_device(index == 0 ? open(options.commands_path, O_RDONLY | O_NONBLOCK) : -1),
+        m_telemetry_device(open_telemetry(options, index)),
+        m_link_device(link ? &link->get_tx() : nullptr, link ? &link->get_rx() : nullptr),
+        m_devices {
+            .accelerometer = {m_accel, IDENTITY, m_sample_sensors ? &m_accel : nullptr},
+            .gyroscope = {m_gyro, IDENTITY, m_sample_sensors ? &m_gyro : nullptr},
+            .imu = options.imu ? &m_imu : nullptr,
+            .log_device = &m_log_device,
+            .telemetry_device = link ? static_cast<emblib::char_dev*>(&m_link_device) : options.telemetry_path ? &m_telemetry_device : nullptr,
+            // Receiver is required, so the other vehicles get a device without any data
+            .receiver_device = link ? static_cast<emblib::char_dev&>(m_link_device) : m_receiver_device,
+#if MP_SIM_VIRTUAL_TIME
+            .time_source = get_virtual_time_us,
+#else
+            .time_source = nullptr,
+#endif
+            .param_device = nullptr
+        },
+        m_stack(m_context, m_devices, m_estimator, m_quad)
+    {}
+
+    bool init() noexcept
+    {
+        return m_stack.init();
+    }
+
+    model& get_model() noexcept
+    {
+        return m_model;
+    }
+
+    flight_context& get_context() noexcept
+    {
+        return m_context;
+    }
+
+    vehicle& get_vehicle() noexcept
+    {
+        return m_quad;
+    }
+
+    /**
+     * Fill the sensor FIFOs or signal the IMU data ready, should be called after every physics step
+     */
+    void sample_sensors() noexcept
+    {
+        if (m_use_imu)
+            m_imu.tick();
+        if (!m_sample_sensors)
+            return;
+        m_accel.sample();
+        m_gyro.sample();
+    }
+
+    /**
+     * Complete the pending async transfers of the devices
+     */
+    void poll_devices() noexcept
+    {
+        m_log_device.poll();
+        m_receiver_device.poll();
+        m_telemetry_device.poll();
+        m_link_device.poll();
+    }
+
+private:
+    static inline const matrix3f IDENTITY = matrix3f::diagonal(1.f);
+
+    /**
+     * Output data rate of the sensors, which fill their FIFOs with every physics
+     * step unless they are polled or read as an IMU at the gyroscope task rate
+     */
+    static float get_sensor_rate(const options_s& options) noexcept
+    {
+        const bool task_rate = options.polled_sensors || options.imu;
+        const auto period = task_rate ? std::chrono::duration<float>(TASK_GYRO_PERIOD) : std::chrono::duration<float>(SIM_PERIOD);
+        return 1.f / period.count();
+    }
+
+#if MP_SIM_VIRTUAL_TIME
+    /**
+     * Time of the virtual clock, which only moves when every task waits
+     */
+    static uint64_t get_virtual_time_us()
+    {
+        return static_cast<uint64_t>(xTaskGetTickCount()) * (1000000 / configTICK_RATE_HZ);
+    }
+#endif
+
+    static int open_telemetry(const options_s& options, size_t index) noexcept
+    {
+        if (!options.telemetry_path)
+            return -1;
+        if (options.vehicle_count == 1)
+            return open(options.telemetry_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s.%u", options.telemetry_path, static_cast<unsigned>(index));
+        return open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+private:
+    motor m_motor_fl, m_motor_fr, m_motor_bl, m_motor_br;
+    copter_controller_pid m_controller;
+    sim_quadcopter m_quad;
+    ekf_inertial m_estimator;
+
+    model m_model;
+    accelerometer m_accel;
+    gyroscope m_gyro;
+    bool m_sample_sensors;
+    imu m_imu;
+    bool m_use_imu;
+
+    posix_char_dev m_log_device;
+    posix_char_dev m_receiver_device;
+    posix_char_dev m_telemetry_device;
+    shm_char_dev m_link_device;
+    const devices_s m_devices;
+
+    flight_stack m_stack;
+};
+
+/**
+ * Task which steps the physics, completes the async transfers of the
+ * devices and stops the simulation with the reports once the time is up
+ */
+class task_sim : public emblib::task {
+
+public:
+    explicit task_sim(sim_vehicle* const* vehicles, const options_s& options, shm_link& link) noexcept :
+        emblib::task("Task sim", SIM_PRIORITY, m_task_stack),
+        m_vehicles(vehicles),
+        m_options(options),
+        m_link(link)
+    {}
+
+private:
+    void run() noexcept override
+    {
+        const uint64_t end_us = get_time_us() + static_cast<uint64_t>(m_options.duration * 1e6f);
+        while (m_options.duration == 0.f || get_time_us() < end_us) {
+            for (size_t i = 0; i < m_options.vehicle_count; i++) {
+                m_vehicles[i]->get_model().step(SIM_DT);
+                m_vehicles[i]->sample_sensors();
+            }
+            poll_devices();
+            sleep_periodic(SIM_PERIOD);
+        }
+        finish();
+    }
+
+    void poll_devices() noexcept
+    {
+        for (size_t i = 0; i < m_options.vehicle_count; i++)
+            m_vehicles[i]->poll_devices();
+    }
+
+    /**
+     * Report the run and exit the process
+     */
+    void finish() noexcept
+    {
+        for (size_t i = 0; i < m_options.vehicle_count; i++) {
+            // Reports go through the logger of the vehicle
+            sim_vehicle& vehicle = *m_vehicles[i];
+            flight_context::set_current(&vehicle.get_context());
+
+            const truth_s truth = vehicle.get_model().get_truth();
+            log_info("Simulation of vehicle ", i, " done, position ", truth.position(0), " ", truth.position(1), " ", truth.position(2));
+            mp::task::log_timing_report();
+            vehicle.get_vehicle().log_latency_report();
+
+            if (i == 0 && m_options.trace_path) {
+                const int fd = open(m_options.trace_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                posix_char_dev trace_device(fd);
+                if (fd < 0 || !mp::task::write_trace_json(trace_device))
+                    log_error("Failed to write the trace!");
+                if (fd >= 0)
+                    close(fd);
+            }
+        }
+
+        // Logs are sent asynchronously, so keep completing the transfers for a while
+        const uint64_t drain_end_us = get_time_us() + std::chrono::microseconds(SIM_LOG_DRAIN_TIME).count();
+        while (get_time_us() < drain_end_us) {
+            poll_devices();
+            sleep_periodic(SIM_PERIOD);
+        }
+        // Tasks never return, so the process is ended without destroying them,
+        // and the link is removed here since its destructor won't run
+        m_link.close();
+        _exit(0);
+    }
+
+private:
+    emblib::task_stack_t<4096> m_task_stack;
+    sim_vehicle* const* m_vehicles;
+    const options_s& m_options;
+    shm_link& m_link;
+};
+
+static bool parse_options(int argc, char* argv[], options_s& options) noexcept
+{
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "--duration") && has_value)
+            options.duration = std::strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--vehicles") && has_value)
+            options.vehicle_count = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--telemetry") && has_value)
+            options.telemetry_path = argv[++i];
+        else if (!strcmp(argv[i], "--commands") && has_value)
+            options.commands_path = argv[++i];
+        else if (!strcmp(argv[i], "--trace") && has_value)
+            options.trace_path = argv[++i];
+        else if (!strcmp(argv[i], "--link") && has_value)
+            options.link_name = argv[++i];
+        else if (!strcmp(argv[i], "--polled-sensors"))
+            options.polled_sensors = true;
+        else if (!strcmp(argv[i], "--imu"))
+            options.imu = true;
+        else
+            return false;
+    }
+    return options.duration >= 0.f && options.vehicle_count > 0 && (MP_MULTI_INSTANCE || options.vehicle_count == 1);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace mp;
+    using namespace mp::sim;
+
+    static options_s options;
+    if (!parse_options(argc, argv, options)) {
+        fprintf(
+            stderr,
+            "Usage: %s [--duration SECONDS] [--vehicles COUNT] [--telemetry FILE] [--commands FILE] [--trace FILE] [--link NAME] [--polled-sensors] [--imu]\n",
+            argv[0]
+        );
+        return 1;
+    }
+
+    // Around 250g of thrust per motor for a 500g quad
+    static const quadcopter_params_s params {
+        {
+            0.5f, // mass
+            vector3f{2.5e-3f, 2.5e-3f, 4.5e-3f}.as_diagonal(), // moment_of_inertia
+            0.1f // lin_drag_c
+        },
+        0.08f, // width_half
+        0.08f, // length_half
+        2.5f, // thrust_coeff
+        0.05f // torque_coeff
+    };
+
+#if MP_SIM_VIRTUAL_TIME
+    // All the tasks run on this thread, so the port switches the thread local pointers with them
+#if MP_MULTI_INSTANCE
+    xPortAddTaskLocalSlot(reinterpret_cast<void**>(flight_context::get_current_storage()));
+#endif
+#if MP_TRACE
+    xPortAddTaskLocalSlot(reinterpret_cast<void**>(trace_ring::get_current_storage()));
+#endif
+#endif
+
+    static shm_link link;
+    if (options.link_name && !link.create(options.link_name)) {
+        fprintf(stderr, "Failed to create the shared memory link %s\n", options.link_name);
+        return 1;
+    }
+
+    // Vehicles live until the process exits
+    static std::vector<sim_vehicle*> vehicles;
+    for (size_t i = 0; i < options.vehicle_count; i++) {
+        vehicles.push_back(new sim_vehicle(params, options, i, i == 0 && link.is_open() ? &link : nullptr));
+        if (!vehicles.back()->init())
+            return 1;
+    }
+
+    static task_sim sim_task(vehicles.data(), options, link);
+
+    log_info("Starting the scheduler...");
+    emblib::task::start_tasks();
+
+    // Should never reach this
+    return 1;
+}
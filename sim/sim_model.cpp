@@ -0,0 +1,51 @@
+#include "sim_model.hpp"
+#include "util/constants.hpp"
+
+namespace mp::sim {
+
+void model::step(float dt) noexcept
+{
+    truth_s next = m_truth;
+    const vector3f& v = m_truth.velocity;
+    const vector3f& w = m_truth.angular_velocity;
+    const quaternionf& q = m_truth.rotationq;
+
+    vector3f a = m_copter.get_flight_linear_acceleration(v, q);
+    vector3f dw = m_copter.get_flight_angular_acceleration(v, w, q);
+
+    // Resting on the ground, which cancels the gravity and any rotation
+    const bool grounded = m_truth.position(2) <= 0.f && a(2) <= 0.f;
+    if (grounded) {
+        a = vector3f(0);
+        dw = vector3f(0);
+        next.velocity = vector3f(0);
+        next.angular_velocity = vector3f(0);
+        next.position(2) = 0.f;
+    }
+
+    // Semi-implicit Euler, the velocities are updated first
+    next.velocity = next.velocity + dt * a;
+    next.position = next.position + dt * next.velocity;
+    next.acceleration = a;
+    next.angular_velocity = next.angular_velocity + dt * dw;
+
+    // Same quaternion derivative as in the EKF, with the angular velocity in the local frame
+    const float w1 = next.angular_velocity(0);
+    const float w2 = next.angular_velocity(1);
+    const float w3 = next.angular_velocity(2);
+    const matrixf<4> b {
+        {0, -w1, -w2, -w3},
+        {w1, 0, w3, -w2},
+        {w2, -w3, 0, w1},
+        {w3, w2, -w1, 0}
+    };
+    vector4f qv = q.as_vector();
+    qv = qv + (dt / 2.f) * b.matmul(qv);
+    qv /= qv.norm();
+    next.rotationq = quaternionf(qv(0), qv(1), qv(2), qv(3));
+
+    emblib::scoped_lock lock(m_truth_mutex);
+    m_truth = next;
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "vehicles/copter/copter.hpp"
+#include "util/math.hpp"
+#include <emblib/rtos/mutex.hpp>
+
+namespace mp::sim {
+
+/**
+ * True state of the simulated copter, in the same frames as `state_s`
+ */
+struct truth_s {
+    vector3f position {0, 0, 0};
+    vector3f velocity {0, 0, 0};
+    vector3f acceleration {0, 0, 0};
+    vector3f angular_velocity {0, 0, 0};
+    quaternionf rotationq {1, 0, 0, 0};
+};
+
+/**
+ * Rigid body simulation of the copter
+ *
+ * Accelerations come from the flight dynamics of the copter itself, so the
+ * model uses exactly the equations of the EKF, with the thrust and torque
+ * produced by the throttles the vehicle wrote to the simulated motors.
+ * The ground is a plane at zero height which the copter stands on until
+ * the thrust lifts it.
+ */
+class model {
+
+public:
+    explicit model(const copter& copter) noexcept :
+        m_copter(copter)
+    {}
+
+    /**
+     * Advance the simulation by the time step
+     */
+    void step(float dt) noexcept;
+
+    /**
+     * Get the current state, can be called from any task
+     */
+    truth_s get_truth() noexcept
+    {
+        emblib::scoped_lock lock(m_truth_mutex);
+        return m_truth;
+    }
+
+private:
+    const copter& m_copter;
+
+    // Only written by `step`, so it can be read without the lock there
+    truth_s m_truth;
+    emblib::mutex m_truth_mutex;
+};
+
+}
@@ -0,0 +1,127 @@
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdlib.h>
+#include <ucontext.h>
+
+/*
+ * Deterministic FreeRTOS port for the simulation
+ *
+ * Every task is a ucontext coroutine on the thread which started the
+ * scheduler, and a context switch happens only when the kernel yields, so
+ * the ready task with the highest priority always runs and the order of
+ * the tasks is the same on every run. There is no tick interrupt: when no
+ * task is ready, the idle hook advances the tick at once, so time spent
+ * waiting for the next deadline costs nothing and a task iteration takes
+ * no simulated time.
+ */
+
+// Host stack of a task, the FreeRTOS stack only holds the context pointer
+#define SIM_TASK_STACK_SIZE (256 * 1024)
+// Maximum number of task local slots
+#define SIM_TASK_LOCAL_SLOTS 4
+
+typedef struct {
+    ucontext_t context;
+    TaskFunction_t code;
+    void* parameters;
+    void* stack;
+    // Values of the task local slots while the task is switched out
+    void* local[SIM_TASK_LOCAL_SLOTS];
+} task_context_t;
+
+static ucontext_t scheduler_context;
+static task_context_t* running = NULL;
+static void** task_local_slots[SIM_TASK_LOCAL_SLOTS];
+static size_t task_local_slot_count = 0;
+
+/*
+ * The first member of the TCB is the top of the stack returned by
+ * pxPortInitialiseStack, where the pointer to the task context is kept
+ */
+static task_context_t* get_task_context(void* tcb)
+{
+    return *(task_context_t**) *(StackType_t**) tcb;
+}
+
+static void task_entry(void)
+{
+    running->code(running->parameters);
+    vTaskDelete(NULL);
+}
+
+StackType_t* pxPortInitialiseStack(StackType_t* pxTopOfStack, TaskFunction_t pxCode, void* pvParameters)
+{
+    task_context_t* context = malloc(sizeof(task_context_t));
+    configASSERT(context != NULL);
+    context->code = pxCode;
+    context->parameters = pvParameters;
+    context->stack = malloc(SIM_TASK_STACK_SIZE);
+    configASSERT(context->stack != NULL);
+    for (size_t i = 0; i < SIM_TASK_LOCAL_SLOTS; i++)
+        context->local[i] = NULL;
+
+    getcontext(&context->context);
+    context->context.uc_stack.ss_sp = context->stack;
+    context->context.uc_stack.ss_size = SIM_TASK_STACK_SIZE;
+    context->context.uc_link = NULL;
+    makecontext(&context->context, task_entry, 0);
+
+    *(task_context_t**) pxTopOfStack = context;
+    return pxTopOfStack;
+}
+
+BaseType_t xPortAddTaskLocalSlot(void** slot)
+{
+    if (task_local_slot_count == SIM_TASK_LOCAL_SLOTS)
+        return pdFAIL;
+    task_local_slots[task_local_slot_count++] = slot;
+    return pdPASS;
+}
+
+BaseType_t xPortStartScheduler(void)
+{
+    running = get_task_context(xTaskGetCurrentTaskHandle());
+    for (size_t i = 0; i < task_local_slot_count; i++)
+        *task_local_slots[i] = running->local[i];
+    swapcontext(&scheduler_context, &running->context);
+    // Returns once the scheduler is ended
+    return pdTRUE;
+}
+
+void vPortEndScheduler(void)
+{
+    task_context_t* previous = running;
+    running = NULL;
+    swapcontext(&previous->context, &scheduler_context);
+}
+
+void vPortYield(void)
+{
+    vTaskSwitchContext();
+
+    task_context_t* next = get_task_context(xTaskGetCurrentTaskHandle());
+    if (next != running) {
+        task_context_t* previous = running;
+        running = next;
+        for (size_t i = 0; i < task_local_slot_count; i++) {
+            previous->local[i] = *task_local_slots[i];
+            *task_local_slots[i] = next->local[i];
+        }
+        swapcontext(&previous->context, &next->context);
+    }
+}
+
+void vPortCleanUpTCB(void* pxTCB)
+{
+    // Called by the idle task, so never for the running task
+    task_context_t* context = get_task_context(pxTCB);
+    free(context->stack);
+    free(context);
+}
+
+void vApplicationIdleHook(void)
+{
+    // No task is ready, so move on to the next tick right away
+    if (xTaskIncrementTick() != pdFALSE)
+        vPortYield();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// FreeRTOS port running every task as a ucontext coroutine on a single
+// host thread, with the tick advanced by the idle task, see port.c
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define portSTACK_TYPE                  unsigned long
+#define portBASE_TYPE                   long
+#define portPOINTER_SIZE_TYPE           uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#if (configTICK_TYPE_WIDTH_IN_BITS == TICK_TYPE_WIDTH_64_BITS)
+typedef uint64_t TickType_t;
+#define portMAX_DELAY                   ((TickType_t) 0xffffffffffffffffULL)
+#else
+typedef uint32_t TickType_t;
+#define portMAX_DELAY                   ((TickType_t) 0xffffffffUL)
+#endif
+
+// Nothing can interrupt a task, so every access is atomic
+#define portTICK_TYPE_IS_ATOMIC         1
+
+#define portSTACK_GROWTH                (-1)
+#define portHAS_STACK_OVERFLOW_CHECKING 0
+#define portTICK_PERIOD_MS              ((TickType_t) 1000 / configTICK_RATE_HZ)
+#define portBYTE_ALIGNMENT              8
+#define portNOP()
+#define portMEMORY_BARRIER()
+
+// Tasks only switch when the kernel yields, so there
+// are no interrupts to mask and no critical sections
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+#define portSET_INTERRUPT_MASK_FROM_ISR()       0
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)    ((void) (x))
+
+void vPortYield(void);
+#define portYIELD()                     vPortYield()
+#define portYIELD_FROM_ISR(x)           do { if (x) vPortYield(); } while (0)
+#define portEND_SWITCHING_ISR(x)        portYIELD_FROM_ISR(x)
+
+#define portTASK_FUNCTION_PROTO(vFunction, pvParameters) void vFunction(void* pvParameters)
+#define portTASK_FUNCTION(vFunction, pvParameters) void vFunction(void* pvParameters)
+
+void vPortCleanUpTCB(void* pxTCB);
+#define portCLEAN_UP_TCB(pxTCB)         vPortCleanUpTCB(pxTCB)
+
+/*
+ * Keep the pointer at the slot separate for every task, like a thread
+ * local variable would be if the tasks were threads. Must be called
+ * before the scheduler starts, fails if all the slots are taken
+ */
+BaseType_t xPortAddTaskLocalSlot(void** slot);
+
+#ifdef __cplusplus
+}
+#endif
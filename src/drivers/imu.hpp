@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+
+namespace mp {
+
+/**
+ * Inertial measurement unit with an accelerometer and a gyroscope on one chip
+ *
+ * Implemented by the drivers of such chips next to the `emblib` interfaces of
+ * the two sensors, so that both are read in one bus transaction whenever the
+ * chip signals that a new sample is ready.
+ */
+class imu {
+
+public:
+    using callback_t = std::function<void()>;
+
+    /**
+     * Read both sensors from the same sample
+     * @returns false if the read failed
+     */
+    virtual bool read_imu(float (&accelerometer)[3], float (&gyroscope)[3]) noexcept = 0;
+
+    /**
+     * Rate at which new samples are ready in Hz
+     */
+    virtual float get_output_data_rate() const noexcept = 0;
+
+    /**
+     * Is the data ready interrupt available, checked before the IMU is used
+     */
+    virtual bool has_data_ready() const noexcept = 0;
+
+    /**
+     * Set the callback of the data ready interrupt
+     * @note The callback is called from the interrupt
+     * @returns false if the interrupt is not available
+     */
+    virtual bool set_data_ready_callback(const callback_t& callback) noexcept = 0;
+};
+
+}
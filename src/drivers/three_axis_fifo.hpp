@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+namespace mp {
+
+/**
+ * Batch access to the sample FIFO of a three axis sensor
+ *
+ * Implemented by the drivers of sensors which buffer their samples at the
+ * output data rate, next to `emblib::three_axis_sensor`, so that the sensor
+ * task can read every sample taken since its last wake-up in one burst.
+ */
+template <typename data_type>
+class three_axis_fifo {
+
+public:
+    /**
+     * Read the oldest samples from the FIFO
+     * @param read_count Set to the number of samples read, which is less
+     * than `max_count` if the FIFO had fewer
+     * @param remaining_count Set to the number of newer samples left in
+     * the FIFO, needed to tell when the read samples were taken
+     * @returns false if the read failed
+     */
+    virtual bool read_fifo(data_type (*data)[3], size_t max_count, size_t& read_count, size_t& remaining_count) noexcept = 0;
+
+    /**
+     * Rate at which the sensor fills the FIFO in Hz
+     */
+    virtual float get_output_data_rate() const noexcept = 0;
+};
+
+}
@@ -0,0 +1,64 @@
+#include "biquad.hpp"
+#include <cmath>
+
+namespace mp {
+
+// M_PI is not standard C++
+static constexpr float TWO_PI = 6.28318531f;
+
+/**
+ * Normalize the analog prototype terms of the audio EQ cookbook by a0
+ */
+static biquad_coeffs_s normalize(float b0, float b1, float b2, float a0, float a1, float a2) noexcept
+{
+    return {b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+}
+
+static bool is_valid(float sample_rate, float frequency, float q) noexcept
+{
+    return sample_rate > 0.f && biquad_is_valid_frequency(sample_rate, frequency) && q > 0.f;
+}
+
+biquad_coeffs_s biquad_lowpass(float sample_rate, float cutoff, float q) noexcept
+{
+    if (!is_valid(sample_rate, cutoff, q))
+        return {};
+
+    const float w0 = TWO_PI * cutoff / sample_rate;
+    const float cos_w0 = std::cos(w0);
+    const float alpha = std::sin(w0) / (2.f * q);
+    return normalize(
+        (1.f - cos_w0) / 2.f, 1.f - cos_w0, (1.f - cos_w0) / 2.f,
+        1.f + alpha, -2.f * cos_w0, 1.f - alpha
+    );
+}
+
+biquad_coeffs_s biquad_notch(float sample_rate, float center, float q) noexcept
+{
+    if (!is_valid(sample_rate, center, q))
+        return {};
+
+    const float w0 = TWO_PI * center / sample_rate;
+    const float cos_w0 = std::cos(w0);
+    const float alpha = std::sin(w0) / (2.f * q);
+    return normalize(
+        1.f, -2.f * cos_w0, 1.f,
+        1.f + alpha, -2.f * cos_w0, 1.f - alpha
+    );
+}
+
+biquad_coeffs_s biquad_bandpass(float sample_rate, float center, float q) noexcept
+{
+    if (!is_valid(sample_rate, center, q))
+        return {};
+
+    const float w0 = TWO_PI * center / sample_rate;
+    const float cos_w0 = std::cos(w0);
+    const float alpha = std::sin(w0) / (2.f * q);
+    return normalize(
+        alpha, 0.f, -alpha,
+        1.f + alpha, -2.f * cos_w0, 1.f - alpha
+    );
+}
+
+}
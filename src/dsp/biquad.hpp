@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+
+namespace mp {
+
+/**
+ * Coefficients of a biquad section, normalized so that a0 is 1:
+ * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+ *
+ * Defaults pass the input through unchanged.
+ */
+struct biquad_coeffs_s {
+    float b0 = 1.f;
+    float b1 = 0.f;
+    float b2 = 0.f;
+    float a1 = 0.f;
+    float a2 = 0.f;
+};
+
+// Quality factor of a second order Butterworth section
+inline constexpr float BIQUAD_Q_BUTTERWORTH = 0.70710678f;
+
+/**
+ * Can a section of the frequency be designed, it must be
+ * above 0 and below the Nyquist frequency
+ */
+constexpr bool biquad_is_valid_frequency(float sample_rate, float frequency) noexcept
+{
+    return frequency > 0.f && frequency < sample_rate / 2.f;
+}
+
+/**
+ * Second order low-pass, a cutoff of 0 or above the Nyquist
+ * frequency gives a pass-through section
+ * @param sample_rate In Hz
+ * @param cutoff In Hz, attenuated by 3dB with the Butterworth Q
+ */
+biquad_coeffs_s biquad_lowpass(float sample_rate, float cutoff, float q = BIQUAD_Q_BUTTERWORTH) noexcept;
+
+/**
+ * Notch with unity gain away from the center, a center of 0 or
+ * above the Nyquist frequency gives a pass-through section
+ * @param q Center frequency divided by the -3dB bandwidth
+ */
+biquad_coeffs_s biquad_notch(float sample_rate, float center, float q) noexcept;
+
+/**
+ * Band-pass with unity gain at the center, a center of 0 or
+ * above the Nyquist frequency gives a pass-through section
+ * @param q Center frequency divided by the -3dB bandwidth
+ */
+biquad_coeffs_s biquad_bandpass(float sample_rate, float center, float q) noexcept;
+
+/**
+ * Cascade of biquad sections filtering the three axes of a sensor together
+ *
+ * Every section has its own coefficients, shared by the axes, and is run
+ * in the transposed direct form II. The state is stored as structure of
+ * arrays with a lane per axis, padded to four lanes, so a section is a
+ * few multiply-adds over four floats which the compiler turns into vector
+ * instructions. Coefficients are computed once when configuring, so a
+ * sample costs about 5 multiplies per section and axis, cheap enough to
+ * run at the output data rate of the sensor.
+ */
+template <size_t max_sections>
+class biquad_cascade3 {
+
+public:
+    static constexpr size_t LANES = 4;
+
+    /**
+     * Set the coefficients of the section and restart it from zero
+     * @returns false if the index is out of range
+     */
+    bool set_section(size_t index, const biquad_coeffs_s& coeffs) noexcept
+    {
+        if (index >= max_sections)
+            return false;
+        m_sections[index].coeffs = coeffs;
+        clear_state(m_sections[index]);
+        m_section_count = index + 1 > m_section_count ? index + 1 : m_section_count;
+        return true;
+    }
+
+    /**
+     * Change the coefficients of the section without touching its state,
+     * for retuning while filtering, which keeps the output continuous
+     * @returns false if the section was not set before
+     */
+    bool update_section(size_t index, const biquad_coeffs_s& coeffs) noexcept
+    {
+        if (index >= m_section_count)
+            return false;
+        m_sections[index].coeffs = coeffs;
+        return true;
+    }
+
+    size_t get_section_count() const noexcept
+    {
+        return m_section_count;
+    }
+
+    /**
+     * Clear the state of all the sections, as if the input was always 0
+     */
+    void reset() noexcept
+    {
+        for (section_s& section : m_sections)
+            clear_state(section);
+    }
+
+    /**
+     * Filter one sample of the three axes in place
+     */
+    void process(float (&xyz)[3]) noexcept
+    {
+        alignas(16) float x[LANES] = {xyz[0], xyz[1], xyz[2], 0.f};
+        process_lanes(x);
+        xyz[0] = x[0];
+        xyz[1] = x[1];
+        xyz[2] = x[2];
+    }
+
+    /**
+     * Filter a block of consecutive samples in place
+     */
+    void process(float (*samples)[3], size_t count) noexcept
+    {
+        for (size_t i = 0; i < count; i++)
+            process(samples[i]);
+    }
+
+private:
+    struct section_s {
+        biquad_coeffs_s coeffs;
+        // Padding lane stays 0 since its input is always 0
+        alignas(16) float z1[LANES] = {};
+        alignas(16) float z2[LANES] = {};
+    };
+
+    static void clear_state(section_s& section) noexcept
+    {
+        for (size_t i = 0; i < LANES; i++) {
+            section.z1[i] = 0.f;
+            section.z2[i] = 0.f;
+        }
+    }
+
+    void process_lanes(float (&x)[LANES]) noexcept
+    {
+        for (size_t s = 0; s < m_section_count; s++) {
+            section_s& section = m_sections[s];
+            const biquad_coeffs_s& c = section.coeffs;
+            for (size_t i = 0; i < LANES; i++) {
+                const float y = c.b0 * x[i] + section.z1[i];
+                section.z1[i] = c.b1 * x[i] - c.a1 * y + section.z2[i];
+                section.z2[i] = c.b2 * x[i] - c.a2 * y;
+                x[i] = y;
+            }
+        }
+    }
+
+private:
+    section_s m_sections[max_sections];
+    size_t m_section_count = 0;
+};
+
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "biquad.hpp"
+#include "fft.hpp"
+#include <cmath>
+#include <cstddef>
+
+namespace mp {
+
+/**
+ * Notch filters following the strongest peaks of the spectrum of a three
+ * axis signal, for removing vibration whose frequency changes with throttle
+ *
+ * The last `fft_size` samples of every axis are kept, and their power
+ * spectra (with a Hann window) are summed. The strongest local maxima within
+ * the band, refined by parabolic interpolation, retune the notches, which
+ * are shared by the axes since the vibration of the frame shows up on all
+ * of them. A peak has to stand out from the mean power of the band to be
+ * followed, otherwise its notch passes the signal through.
+ *
+ * The analysis is split into steps, each doing at most a window and a load,
+ * one FFT stage or the peak search, so that calling `step` once per sample
+ * bounds the added cost of every sample. A whole analysis takes
+ * `STEP_COUNT` samples, after which the next one starts with the newest window.
+ */
+template <size_t fft_size, size_t max_notches>
+class dynamic_notch {
+
+    using fft_t = real_fft<fft_size>;
+
+    // Load, the stages and the power of each axis, then the peak search
+    static constexpr size_t AXIS_STEP_COUNT = fft_t::STAGE_COUNT + 2;
+
+public:
+    static constexpr size_t STEP_COUNT = 3 * AXIS_STEP_COUNT + 1;
+    // Peaks below this multiple of the mean power of the band are ignored
+    static constexpr float PEAK_RATIO = 3.f;
+    // Weight of a new frequency estimate against the previous one
+    static constexpr float SMOOTHING = 0.5f;
+
+    dynamic_notch() noexcept
+    {
+        for (size_t i = 0; i < fft_size; i++) {
+            const float s = std::sin(3.14159265f * i / fft_size);
+            m_window[i] = s * s;
+        }
+    }
+
+    /**
+     * @param notch_count Number of followed peaks, up to `max_notches`
+     * @param min_hz Lowest followed frequency
+     * @param max_hz Highest followed frequency, limited to below the Nyquist frequency
+     * @param q Quality factor of the notches
+     */
+    void configure(float sample_rate, size_t notch_count, float min_hz, float max_hz, float q) noexcept
+    {
+        m_sample_rate = sample_rate;
+        m_notch_count = notch_count < max_notches ? notch_count : max_notches;
+        m_q = q;
+
+        const float bin_hz = sample_rate / fft_size;
+        // The first and last bins have no neighbors for the interpolation
+        m_min_bin = min_hz / bin_hz > 1.f ? static_cast<size_t>(min_hz / bin_hz) : 1;
+        m_max_bin = max_hz / bin_hz < fft_t::BIN_COUNT - 2 ? static_cast<size_t>(max_hz / bin_hz) : fft_t::BIN_COUNT - 2;
+
+        for (size_t i = 0; i < m_notch_count; i++) {
+            m_frequencies[i] = 0.f;
+            m_notches.set_section(i, {});
+        }
+        m_step = 0;
+    }
+
+    /**
+     * Add the sample to the analysis window and filter it in place
+     */
+    void process(float (&xyz)[3]) noexcept
+    {
+        for (size_t axis = 0; axis < 3; axis++)
+            m_history[axis][m_history_index] = xyz[axis];
+        m_history_index = (m_history_index + 1) % fft_size;
+        m_history_count += m_history_count < fft_size;
+
+        m_notches.process(xyz);
+    }
+
+    /**
+     * Advance the analysis by one step, should be called once per sample
+     */
+    void step() noexcept
+    {
+        // Nothing to analyze until the window is full
+        if (m_notch_count == 0 || m_history_count < fft_size)
+            return;
+
+        if (m_step < 3 * AXIS_STEP_COUNT) {
+            const size_t axis = m_step / AXIS_STEP_COUNT;
+            const size_t axis_step = m_step % AXIS_STEP_COUNT;
+            if (axis_step == 0)
+                load(axis);
+            else if (axis_step <= fft_t::STAGE_COUNT)
+                m_fft.run_stage(axis_step - 1);
+            else
+                m_fft.compute_power(m_power);
+            m_step++;
+        } else {
+            retune();
+            m_step = 0;
+        }
+    }
+
+    size_t get_notch_count() const noexcept
+    {
+        return m_notch_count;
+    }
+
+    /**
+     * Center frequency of the notch in Hz, 0 if it's not following a peak
+     */
+    float get_frequency(size_t index) const noexcept
+    {
+        return m_frequencies[index];
+    }
+
+private:
+    void load(size_t axis) noexcept
+    {
+        if (axis == 0) {
+            for (float& power : m_power)
+                power = 0.f;
+        }
+
+        // Oldest sample first
+        for (size_t i = 0; i < fft_size; i++)
+            m_windowed[i] = m_window[i] * m_history[axis][(m_history_index + i) % fft_size];
+        m_fft.load(m_windowed);
+    }
+
+    void retune() noexcept
+    {
+        float mean = 0.f;
+        for (size_t k = m_min_bin; k <= m_max_bin; k++)
+            mean += m_power[k];
+        mean /= m_max_bin - m_min_bin + 1;
+
+        // Strongest local maxima, strongest first
+        size_t peaks[max_notches];
+        size_t peak_count = 0;
+        for (size_t k = m_min_bin; k <= m_max_bin; k++) {
+            const float power = m_power[k];
+            if (power <= PEAK_RATIO * mean || power <= m_power[k - 1] || power < m_power[k + 1])
+                continue;
+
+            size_t i = peak_count < m_notch_count ? peak_count++ : m_notch_count;
+            for (; i > 0 && m_power[peaks[i - 1]] < power; i--) {
+                if (i < m_notch_count)
+                    peaks[i] = peaks[i - 1];
+            }
+            if (i < m_notch_count)
+                peaks[i] = k;
+        }
+
+        // Ordered by frequency so that each notch follows the same peak
+        float frequencies[max_notches];
+        for (size_t i = 0; i < peak_count; i++)
+            frequencies[i] = interpolate(peaks[i]);
+        for (size_t i = 1; i < peak_count; i++) {
+            for (size_t j = i; j > 0 && frequencies[j - 1] > frequencies[j]; j--) {
+                const float swap = frequencies[j];
+                frequencies[j] = frequencies[j - 1];
+                frequencies[j - 1] = swap;
+            }
+        }
+
+        for (size_t i = 0; i < m_notch_count; i++) {
+            if (i < peak_count) {
+                m_frequencies[i] = m_frequencies[i] > 0.f
+                    ? m_frequencies[i] + SMOOTHING * (frequencies[i] - m_frequencies[i])
+                    : frequencies[i];
+                m_notches.update_section(i, biquad_notch(m_sample_rate, m_frequencies[i], m_q));
+            } else {
+                m_frequencies[i] = 0.f;
+                m_notches.update_section(i, {});
+            }
+        }
+    }
+
+    /**
+     * Frequency of the peak at the bin, refined with a parabola through its neighbors
+     */
+    float interpolate(size_t bin) const noexcept
+    {
+        const float left = m_power[bin - 1];
+        const float center = m_power[bin];
+        const float right = m_power[bin + 1];
+        const float denominator = left - 2.f * center + right;
+        const float offset = denominator != 0.f ? 0.5f * (left - right) / denominator : 0.f;
+        return (bin + offset) * m_sample_rate / fft_size;
+    }
+
+private:
+    fft_t m_fft;
+    float m_window[fft_size];
+    float m_history[3][fft_size] = {};
+    size_t m_history_index = 0;
+    size_t m_history_count = 0;
+    // Kept off the stack of the calling task
+    float m_windowed[fft_size];
+    float m_power[fft_t::BIN_COUNT] = {};
+    size_t m_step = 0;
+
+    float m_sample_rate = 0.f;
+    size_t m_notch_count = 0;
+    size_t m_min_bin = 1;
+    size_t m_max_bin = 1;
+    float m_q = 1.f;
+    float m_frequencies[max_notches] = {};
+    biquad_cascade3<max_notches> m_notches;
+};
+
+}
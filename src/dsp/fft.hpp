@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+namespace mp {
+
+/**
+ * Power spectrum of a block of real samples, computed in steps
+ *
+ * The real input is packed into a complex FFT of half the size, which is
+ * run in place as radix-2 decimation in time and then split into the
+ * spectrum of the real signal. Each stage is a separate call, so the
+ * work can be spread over the ticks of a periodic task with every tick
+ * doing at most `size / 4` butterflies:
+ * `load`, `run_stage` for every stage in order, then `compute_power`.
+ */
+template <size_t size>
+class real_fft {
+
+    static_assert(size >= 8 && (size & (size - 1)) == 0, "FFT size must be a power of 2");
+
+    static constexpr size_t HALF = size / 2;
+
+    static constexpr size_t log2(size_t value) noexcept
+    {
+        size_t bits = 0;
+        while ((size_t(1) << bits) < value)
+            bits++;
+        return bits;
+    }
+
+public:
+    // Bins from DC up to just below the Nyquist frequency
+    static constexpr size_t BIN_COUNT = HALF;
+    static constexpr size_t STAGE_COUNT = log2(HALF);
+
+    real_fft() noexcept
+    {
+        for (size_t k = 0; k < HALF; k++) {
+            const float angle = 6.28318531f * k / size;
+            m_cos[k] = std::cos(angle);
+            m_sin[k] = std::sin(angle);
+        }
+    }
+
+    /**
+     * Pack the samples as complex pairs in bit reversed order
+     * @param samples Exactly `size` of them
+     */
+    void load(const float* samples) noexcept
+    {
+        for (size_t j = 0; j < HALF; j++) {
+            const size_t r = reverse_bits(j);
+            m_re[r] = samples[2 * j];
+            m_im[r] = samples[2 * j + 1];
+        }
+    }
+
+    /**
+     * Run the butterflies of a stage of the half size complex FFT
+     */
+    void run_stage(size_t stage) noexcept
+    {
+        const size_t half_span = size_t(1) << stage;
+        const size_t span = 2 * half_span;
+        // Twiddles of the half size FFT are every other one of the full size table
+        const size_t twiddle_stride = size / span;
+
+        for (size_t start = 0; start < HALF; start += span) {
+            for (size_t k = 0; k < half_span; k++) {
+                const size_t a = start + k;
+                const size_t b = a + half_span;
+                const float w_re = m_cos[k * twiddle_stride];
+                const float w_im = -m_sin[k * twiddle_stride];
+                const float t_re = m_re[b] * w_re - m_im[b] * w_im;
+                const float t_im = m_re[b] * w_im + m_im[b] * w_re;
+                m_re[b] = m_re[a] - t_re;
+                m_im[b] = m_im[a] - t_im;
+                m_re[a] += t_re;
+                m_im[a] += t_im;
+            }
+        }
+    }
+
+    /**
+     * Split the half size FFT into the spectrum of the real
+     * samples and add its squared magnitude to the power
+     * @param power `BIN_COUNT` values
+     */
+    void compute_power(float* power) const noexcept
+    {
+        for (size_t k = 0; k < HALF; k++) {
+            // Even and odd sample spectra from Z[k] and conj(Z[N/2 - k])
+            const size_t c = (HALF - k) & (HALF - 1);
+            const float even_re = (m_re[k] + m_re[c]) / 2.f;
+            const float even_im = (m_im[k] - m_im[c]) / 2.f;
+            const float odd_re = (m_im[k] + m_im[c]) / 2.f;
+            const float odd_im = -(m_re[k] - m_re[c]) / 2.f;
+
+            // X[k] = E[k] + e^(-2 pi i k / N) O[k]
+            const float x_re = even_re + m_cos[k] * odd_re + m_sin[k] * odd_im;
+            const float x_im = even_im + m_cos[k] * odd_im - m_sin[k] * odd_re;
+            power[k] += x_re * x_re + x_im * x_im;
+        }
+    }
+
+private:
+    static size_t reverse_bits(size_t value) noexcept
+    {
+        size_t reversed = 0;
+        for (size_t i = 0; i < STAGE_COUNT; i++) {
+            reversed = (reversed << 1) | (value & 1);
+            value >>= 1;
+        }
+        return reversed;
+    }
+
+private:
+    float m_re[HALF];
+    float m_im[HALF];
+    float m_cos[HALF];
+    float m_sin[HALF];
+};
+
+}
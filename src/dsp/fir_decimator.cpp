@@ -0,0 +1,21 @@
+#include "fir_decimator.hpp"
+#include <cmath>
+
+namespace mp {
+
+// M_PI is not standard C++
+static constexpr float PI = 3.14159265f;
+
+float fir_lowpass_tap(size_t index, size_t tap_count, float cutoff) noexcept
+{
+    if (cutoff <= 0.f || cutoff >= 0.5f || tap_count < 2)
+        return index == 0 ? 1.f : 0.f;
+
+    // Symmetric Hamming window, so the phase is linear
+    const float t = index - (tap_count - 1) / 2.f;
+    const float sinc = t == 0.f ? 2.f * cutoff : std::sin(2.f * PI * cutoff * t) / (PI * t);
+    const float window = 0.54f - 0.46f * std::cos(2.f * PI * index / (tap_count - 1));
+    return sinc * window;
+}
+
+}
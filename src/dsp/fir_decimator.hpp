@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+
+namespace mp {
+
+/**
+ * Tap of a windowed sinc low-pass, not yet normalized to unity gain at DC
+ * @param cutoff Cutoff frequency as a fraction of the sample rate, the
+ * filter passes everything through if it is not between 0 and 0.5
+ */
+float fir_lowpass_tap(size_t index, size_t tap_count, float cutoff) noexcept;
+
+/**
+ * Polyphase FIR decimator for three axis samples
+ *
+ * Low-pass filters the input below half the output rate and keeps every
+ * `factor`-th sample, with `taps_per_phase * factor` taps in total. The
+ * filter runs in the transposed form: every input sample is added to the
+ * `taps_per_phase` outputs it contributes to, so no input history is kept
+ * and each output costs the same as the direct form. Taps are stored per
+ * input phase to make the inner loop contiguous.
+ */
+template <size_t taps_per_phase, size_t max_factor>
+class fir_decimator3 {
+
+public:
+    /**
+     * Design the anti-aliasing filter for the factor and reset the state
+     * @returns false if the factor is 0 or above `max_factor`
+     */
+    bool configure(size_t factor) noexcept
+    {
+        if (factor == 0 || factor > max_factor)
+            return false;
+
+        m_factor = factor;
+        const size_t tap_count = taps_per_phase * factor;
+        const float cutoff = 0.5f / factor;
+
+        // Input at phase p is the (factor - 1 - p)-th newest of its block
+        float sum = 0.f;
+        for (size_t phase = 0; phase < factor; phase++) {
+            for (size_t j = 0; j < taps_per_phase; j++) {
+                m_taps[phase][j] = fir_lowpass_tap(j * factor + factor - 1 - phase, tap_count, cutoff);
+                sum += m_taps[phase][j];
+            }
+        }
+        for (size_t phase = 0; phase < factor; phase++) {
+            for (float& tap : m_taps[phase])
+                tap /= sum;
+        }
+        reset();
+        return true;
+    }
+
+    void reset() noexcept
+    {
+        for (auto& sums : m_sums) {
+            for (float& sum : sums)
+                sum = 0.f;
+        }
+        m_phase = 0;
+        m_head = 0;
+    }
+
+    size_t get_factor() const noexcept
+    {
+        return m_factor;
+    }
+
+    /**
+     * Delay of the linear phase filter in input sample periods, by which
+     * an output lags the newest input it includes
+     */
+    float get_group_delay() const noexcept
+    {
+        return (taps_per_phase * m_factor - 1) / 2.f;
+    }
+
+    /**
+     * Add an input sample
+     * @returns true if an output sample was completed, which is written to `output`
+     */
+    bool process(const float (&input)[3], float (&output)[3]) noexcept
+    {
+        const float* taps = m_taps[m_phase];
+        for (size_t j = 0, index = m_head; j < taps_per_phase; j++, index = index + 1 < taps_per_phase ? index + 1 : 0) {
+            for (size_t axis = 0; axis < 3; axis++)
+                m_sums[index][axis] += taps[j] * input[axis];
+        }
+
+        if (++m_phase < m_factor)
+            return false;
+
+        // Oldest sum has all of its inputs now, so it's reused for the newest output
+        for (size_t axis = 0; axis < 3; axis++) {
+            output[axis] = m_sums[m_head][axis];
+            m_sums[m_head][axis] = 0.f;
+        }
+        m_head = m_head + 1 < taps_per_phase ? m_head + 1 : 0;
+        m_phase = 0;
+        return true;
+    }
+
+private:
+    float m_taps[max_factor][taps_per_phase] = {};
+    // Partial sums of the outputs in progress, oldest at the head
+    float m_sums[taps_per_phase][3] = {};
+    size_t m_factor = 0;
+    size_t m_phase = 0;
+    size_t m_head = 0;
+};
+
+}
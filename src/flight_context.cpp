@@ -0,0 +1,11 @@
+#include "flight_context.hpp"
+
+namespace mp {
+
+flight_context& flight_context::get_default() noexcept
+{
+    static flight_context s_default;
+    return s_default;
+}
+
+}
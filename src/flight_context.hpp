@@ -0,0 +1,117 @@
+#pragma once
+
+#include "params/param_store.hpp"
+#include "tasks/task_config.hpp"
+#include "util/log_binary.hpp"
+#include "util/logger.hpp"
+
+#ifndef MP_MULTI_INSTANCE
+#define MP_MULTI_INSTANCE 0
+#endif
+
+namespace mp {
+
+class task;
+
+/**
+ * State shared by all the modules of one flight stack: the loggers, the
+ * parameters and the registry of the tasks
+ *
+ * The `get_instance` functions of these return the ones of the current
+ * context, or of the default context if there is none, which is what a
+ * port with a single minipilot uses. Every task makes the context it
+ * was created in current when it starts running.
+ *
+ * With `MP_MULTI_INSTANCE` the current context is kept per thread, so
+ * the tasks of multiple flight stacks can run in one process. Otherwise
+ * it is a single pointer set by the last flight stack, which avoids
+ * thread local storage on the targets.
+ */
+class flight_context {
+
+public:
+    flight_context() noexcept :
+        m_tasks{},
+        m_task_count(0)
+    {}
+
+    flight_context(const flight_context&) = delete;
+    flight_context& operator=(const flight_context&) = delete;
+
+    logger& get_logger() noexcept
+    {
+        return m_logger;
+    }
+
+    binary_logger& get_binary_logger() noexcept
+    {
+        return m_binary_logger;
+    }
+
+    param_store& get_param_store() noexcept
+    {
+        return m_param_store;
+    }
+
+    /**
+     * Add the task to the registry
+     * @returns false if the registry is full
+     */
+    bool add_task(task& task) noexcept
+    {
+        if (m_task_count >= TASK_MAX_COUNT)
+            return false;
+        m_tasks[m_task_count++] = &task;
+        return true;
+    }
+
+    size_t get_task_count() const noexcept
+    {
+        return m_task_count;
+    }
+
+    task& get_task(size_t index) noexcept
+    {
+        return *m_tasks[index];
+    }
+
+    static flight_context& get_current() noexcept
+    {
+        return s_current ? *s_current : get_default();
+    }
+
+    /**
+     * Set the current context, `nullptr` for the default one
+     */
+    static void set_current(flight_context* context) noexcept
+    {
+        s_current = context;
+    }
+
+    /**
+     * Storage of the current context pointer, for schedulers which run
+     * multiple tasks on one thread and have to switch it with the task
+     */
+    static flight_context** get_current_storage() noexcept
+    {
+        return &s_current;
+    }
+
+    static flight_context& get_default() noexcept;
+
+private:
+    logger m_logger;
+    binary_logger m_binary_logger;
+    param_store m_param_store;
+
+    task* m_tasks[TASK_MAX_COUNT];
+    size_t m_task_count;
+
+#if MP_MULTI_INSTANCE
+    inline static thread_local flight_context* s_current = nullptr;
+#else
+    inline static flight_context* s_current = nullptr;
+#endif
+};
+
+}
@@ -0,0 +1,173 @@
+#include "flight_stack.hpp"
+#include "params/param_store.hpp"
+#include "util/logger.hpp"
+#include <cmath>
+
+namespace mp {
+
+// Timeout for checking if the device is properly working
+inline constexpr auto DEVICE_PROBE_TIMEOUT = std::chrono::milliseconds(10);
+
+template <typename duration_type>
+static float get_rate(duration_type period) noexcept
+{
+    return 1.f / std::chrono::duration<float>(period).count();
+}
+
+bool flight_stack::init() noexcept
+{
+    // Tasks register in the current context and capture it
+    flight_context::set_current(&m_context);
+
+    if (m_devices.time_source) {
+        set_time_source(m_devices.time_source);
+    }
+
+    // Telemetry device is owned by the transmitter task which
+    // multiplexes all the outgoing messages over it
+    if (m_devices.telemetry_device && m_devices.telemetry_device->probe(DEVICE_PROBE_TIMEOUT)) {
+        m_task_transmitter.emplace(*m_devices.telemetry_device);
+    }
+
+    // If the same device is used for logs and telemetry, logs
+    // are sent through the transmitter's log channels. Binary records
+    // need the framing to be told apart from the text, so without
+    // the transmitter the binary messages are logged as text instead
+    emblib::char_dev* log_device = m_devices.log_device;
+    emblib::char_dev* binary_log_device = m_devices.log_device;
+    if (m_task_transmitter && log_device == m_devices.telemetry_device) {
+        log_device = &m_task_transmitter->get_channel(TRANSMITTER_CHANNEL_LOG);
+        binary_log_device = &m_task_transmitter->get_channel(TRANSMITTER_CHANNEL_LOG_BINARY);
+        m_context.get_binary_logger().set_enabled(true);
+    }
+
+    // Initialize the logging system (task) if there is an available logging device
+    if (log_device && log_device->probe(DEVICE_PROBE_TIMEOUT)) {
+        // Create the logging task
+        m_task_logger.emplace(*log_device, *binary_log_device);
+
+        // Logging device is used directly until the scheduler starts
+        m_context.get_logger().set_output_device(*log_device);
+        m_context.get_binary_logger().set_output_device(*binary_log_device);
+        log_info("Logging available!");
+    }
+
+    // Parameters are loaded before creating the tasks which use them, modules
+    // created earlier (like the vehicle) are notified of the loaded values
+    param_store& params = m_context.get_param_store();
+    if (m_devices.param_device) {
+        params.set_storage_device(*m_devices.param_device);
+    }
+    if (!params.load()) {
+        log_warning("Parameters not loaded, using the defaults!");
+    }
+
+    // Accelerometer is required
+    if (!m_devices.accelerometer.sensor.probe()) {
+        log_error("Accelerometer not available!");
+        return false;
+    }
+    // Gyroscope is required
+    if (!m_devices.gyroscope.sensor.probe()) {
+        log_error("Gyroscope not available!");
+        return false;
+    }
+
+    // The IMU task publishes every sample without decimation, so it replaces the sensor
+    // tasks only if its interrupt paces the reads at the rate of the gyroscope task
+    mp::imu* imu = m_devices.imu;
+    const float gyroscope_rate = get_rate(TASK_GYRO_PERIOD);
+    if (imu && !imu->has_data_ready()) {
+        log_warning("IMU data ready not available, using the sensor tasks!");
+        imu = nullptr;
+    } else if (imu && std::fabs(imu->get_output_data_rate() - gyroscope_rate) > TASK_IMU_RATE_TOLERANCE * gyroscope_rate) {
+        log_warning("IMU output data rate is not the gyroscope rate, using the sensor tasks!");
+        imu = nullptr;
+    }
+
+    // Values are published at the output data rate of the IMU if it's
+    // used, otherwise at the rates of the accelerometer and gyroscope tasks
+    const vector3f accelerometer_bias = {
+        params.get<PARAM_ACC_BIAS_X>(),
+        params.get<PARAM_ACC_BIAS_Y>(),
+        params.get<PARAM_ACC_BIAS_Z>()
+    };
+    m_accelerometer.emplace(
+        m_devices.accelerometer.transform,
+        accelerometer_bias,
+        m_devices.accelerometer.sensor.get_noise_density(),
+        imu ? imu->get_output_data_rate() : get_rate(TASK_ACCEL_PERIOD)
+    );
+    m_gyroscope.emplace(
+        m_devices.gyroscope.transform,
+        m_devices.gyroscope.sensor.get_noise_density(),
+        imu ? imu->get_output_data_rate() : gyroscope_rate
+    );
+
+    m_inertial.emplace(*m_accelerometer, *m_gyroscope);
+
+    if (imu) {
+        // Create the IMU task which reads both sensors
+        m_task_imu.emplace(*imu, *m_inertial);
+        log_info("IMU available!");
+    } else {
+        // Create the accelerometer and gyroscope tasks
+        m_task_accelerometer.emplace(m_devices.accelerometer.sensor, *m_accelerometer, m_devices.accelerometer.fifo);
+        m_task_gyroscope.emplace(m_devices.gyroscope.sensor, *m_gyroscope, m_devices.gyroscope.fifo);
+    }
+
+    // Receiver is required
+    if (!m_devices.receiver_device.probe(DEVICE_PROBE_TIMEOUT)) {
+        log_error("Receiver not available!");
+        return false;
+    }
+    // Create the receiver task
+    m_task_receiver.emplace(m_devices.receiver_device);
+
+    // Create the state estimator task
+    m_task_state_estimator.emplace(
+        m_state_estimator,
+        *m_inertial
+    );
+
+    // If there is a telemetry device available, create the telemetry task
+    // Telemetry could also be required (not optional)
+    if (m_task_transmitter) {
+        m_task_telemetry.emplace(
+            m_task_transmitter->get_channel(TRANSMITTER_CHANNEL_TELEMETRY),
+            m_task_transmitter->get_channel(TRANSMITTER_CHANNEL_TELEMETRY_COMPACT),
+            *m_accelerometer,
+            *m_gyroscope,
+            *m_task_state_estimator,
+            m_vehicle
+        );
+        log_info("Telemetry available!");
+    } else {
+        log_warning("Telemetry not available!");
+    }
+
+    static_assert(mp_pb_ParamReport_size <= task_transmitter::MAX_PAYLOAD_SIZE, "Parameter report must fit in a frame");
+
+    // Create the vehicle task
+    m_task_vehicle.emplace(
+        m_vehicle,
+        *m_task_receiver,
+        *m_task_state_estimator,
+        m_task_telemetry ? &*m_task_telemetry : nullptr,
+        m_task_transmitter ? &m_task_transmitter->get_channel(TRANSMITTER_CHANNEL_ACK) : nullptr,
+        m_task_transmitter ? &m_task_transmitter->get_channel(TRANSMITTER_CHANNEL_PARAM) : nullptr
+    );
+
+    log_info("Tasks created!");
+
+    // If a logging device exists, it means the task was already
+    // created, so now switch the logging to go through the logging task
+    if (m_task_logger) {
+        m_context.get_logger().set_output_ring(m_task_logger->get_ring());
+        m_context.get_binary_logger().set_output_ring(m_task_logger->get_ring());
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "main.hpp"
+#include "flight_context.hpp"
+#include "tasks/task_logger.hpp"
+#include "tasks/task_telemetry.hpp"
+#include "tasks/task_transmitter.hpp"
+#include "tasks/task_accelerometer.hpp"
+#include "tasks/task_gyroscope.hpp"
+#include "tasks/task_imu.hpp"
+#include "tasks/task_state_estimator.hpp"
+#include "tasks/task_receiver.hpp"
+#include "tasks/task_vehicle.hpp"
+#include <optional>
+
+namespace mp {
+
+/**
+ * One instance of minipilot, owning its tasks
+ *
+ * `mp::main` runs a single flight stack in the default flight context,
+ * but hosts built with `MP_MULTI_INSTANCE` can create any number of them
+ * in one process before starting the scheduler, each with its own
+ * context, devices, vehicle and state estimator. Modules read the
+ * parameters when they are constructed, so the context of a stack
+ * should be made current before creating its vehicle and estimator.
+ * Optional tasks are only constructed if their devices are available.
+ */
+class flight_stack {
+
+public:
+    explicit flight_stack(
+        flight_context& context,
+        const devices_s& devices,
+        state_estimator& state_estimator,
+        vehicle& vehicle
+    ) noexcept :
+        m_context(context),
+        m_devices(devices),
+        m_state_estimator(state_estimator),
+        m_vehicle(vehicle)
+    {}
+
+    flight_stack(const flight_stack&) = delete;
+    flight_stack& operator=(const flight_stack&) = delete;
+
+    /**
+     * Load the parameters and create the tasks, which start running with the scheduler
+     * @note Leaves the flight context of this stack current for the calling thread
+     * @returns false if a required device is not available
+     */
+    bool init() noexcept;
+
+private:
+    flight_context& m_context;
+    const devices_s m_devices;
+    state_estimator& m_state_estimator;
+    vehicle& m_vehicle;
+
+    std::optional<task_transmitter> m_task_transmitter;
+    std::optional<task_logger> m_task_logger;
+    // Read either by the IMU task or by their own tasks
+    std::optional<accelerometer_channel> m_accelerometer;
+    std::optional<gyroscope_channel> m_gyroscope;
+    std::optional<inertial_channel> m_inertial;
+    std::optional<task_imu> m_task_imu;
+    std::optional<task_accelerometer> m_task_accelerometer;
+    std::optional<task_gyroscope> m_task_gyroscope;
+    std::optional<task_receiver> m_task_receiver;
+    std::optional<task_state_estimator> m_task_state_estimator;
+    std::optional<task_telemetry> m_task_telemetry;
+    std::optional<task_vehicle> m_task_vehicle;
+};
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "drivers/imu.hpp"
+#include "drivers/three_axis_fifo.hpp"
 #include "vehicles/vehicle.hpp"
+#include "util/time.hpp"
 #include <emblib/driver/accelerometer.hpp>
 #include <emblib/driver/char_dev.hpp>
 #include <emblib/driver/gyroscope.hpp>
@@ -18,15 +21,26 @@ struct devices_s {
         emblib::accelerometer& sensor;
         // Map the sensor reading to the mp coordinate frame
         const matrix3f& transform;
+        // Optional, samples are read in bursts and decimated if provided
+        three_axis_fifo<float>* fifo = nullptr;
     } accelerometer;
     struct {
         emblib::gyroscope& sensor;
         // Map the sensor reading to the mp coordinate frame
         const matrix3f& transform;
+        // Optional, samples are read in bursts and decimated if provided
+        three_axis_fifo<float>* fifo = nullptr;
     } gyroscope;
+    // Reads both sensors above on its data ready interrupt instead of their separate tasks,
+    // its output data rate must be the rate of the gyroscope task
+    mp::imu* imu = nullptr;
     emblib::char_dev* log_device;
     emblib::char_dev* telemetry_device;
     emblib::char_dev& receiver_device;
+    // Microsecond timer, the steady clock is used if not provided
+    time_source_t time_source;
+    // Persistent storage of the parameters, defaults are used if not provided
+    emblib::char_dev* param_device;
 };
 
 /**
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * Table of all the runtime parameters
+ *
+ * Each entry is X(id, name, type, default, min, max), where the id becomes
+ * `PARAM_<id>`, the name (at most 23 characters) identifies the parameter
+ * on the host, and the type is one of FLOAT, INT32 or BOOL. Limits are
+ * inclusive and are ignored for BOOL.
+ *
+ * Renaming a parameter changes its id, so its value stored in the
+ * persistent image is dropped and the default is used instead.
+ */
+#define MP_PARAM_TABLE(X) \
+    /* Copter angular velocity PID */ \
+    X(CTRL_W_P,             "ctrl.w.p",             FLOAT,  1.f,    0.f,    100.f)  \
+    X(CTRL_W_I,             "ctrl.w.i",             FLOAT,  0.2f,   0.f,    100.f)  \
+    X(CTRL_W_D,             "ctrl.w.d",             FLOAT,  0.f,    0.f,    100.f)  \
+    /* Copter linear acceleration PID */ \
+    X(CTRL_V_P,             "ctrl.v.p",             FLOAT,  1.f,    0.f,    100.f)  \
+    X(CTRL_V_I,             "ctrl.v.i",             FLOAT,  2.f,    0.f,    100.f)  \
+    X(CTRL_V_D,             "ctrl.v.d",             FLOAT,  0.f,    0.f,    100.f)  \
+    /* EKF process noise */ \
+    X(EKF_V_NOISE,          "ekf.v_noise",          FLOAT,  1.f,    0.f,    100.f)  \
+    X(EKF_A_NOISE,          "ekf.a_noise",          FLOAT,  5e-1f,  0.f,    100.f)  \
+    X(EKF_Q_NOISE,          "ekf.q_noise",          FLOAT,  1e-1f,  0.f,    100.f)  \
+    X(EKF_W_NOISE,          "ekf.w_noise",          FLOAT,  5e-1f,  0.f,    100.f)  \
+    X(EKF_WD_NOISE,         "ekf.wd_noise",         FLOAT,  1e-1f,  0.f,    100.f)  \
+    /* Accelerometer bias in m/s^2, applied on boot */ \
+    X(ACC_BIAS_X,           "acc.bias.x",           FLOAT,  0.f,    -20.f,  20.f)   \
+    X(ACC_BIAS_Y,           "acc.bias.y",           FLOAT,  0.f,    -20.f,  20.f)   \
+    X(ACC_BIAS_Z,           "acc.bias.z",           FLOAT,  0.f,    -20.f,  20.f)   \
+    /* Sensor filters in Hz, applied on boot, 0 disables the filter */ \
+    X(ACC_LPF_HZ,           "acc.lpf_hz",           FLOAT,  0.f,    0.f,    4000.f) \
+    X(GYRO_LPF_HZ,          "gyro.lpf_hz",          FLOAT,  0.f,    0.f,    4000.f) \
+    X(GYRO_NOTCH_HZ,        "gyro.notch_hz",        FLOAT,  0.f,    0.f,    4000.f) \
+    X(GYRO_NOTCH_Q,         "gyro.notch_q",         FLOAT,  3.f,    0.1f,   20.f)   \
+    /* Gyroscope notches following the peaks of the spectrum, applied on boot, 0 disables them */ \
+    X(GYRO_DN_COUNT,        "gyro.dn.count",        INT32,  0.f,    0.f,    3.f)    \
+    X(GYRO_DN_MIN_HZ,       "gyro.dn.min_hz",       FLOAT,  20.f,   0.f,    4000.f) \
+    X(GYRO_DN_MAX_HZ,       "gyro.dn.max_hz",       FLOAT,  90.f,   0.f,    4000.f) \
+    X(GYRO_DN_Q,            "gyro.dn.q",            FLOAT,  4.f,    0.1f,   20.f)   \
+    /* Stick input */ \
+    X(RC_ENABLED,           "rc.enabled",           BOOL,   1.f,    0.f,    1.f)    \
+    X(RC_MAX_RATE,          "rc.max_rate",          FLOAT,  3.f,    0.f,    20.f)   \
+    X(RC_MAX_THRUST_RATIO,  "rc.max_thrust_ratio",  FLOAT,  2.f,    0.f,    10.f)   \
+    /* Vehicle update period */ \
+    X(VEHICLE_PERIOD_MS,    "vehicle.period_ms",    INT32,  50.f,   5.f,    1000.f)
@@ -0,0 +1,148 @@
+#include "param_store.hpp"
+#include "flight_context.hpp"
+#include "util/byte_order.hpp"
+#include "util/crc.hpp"
+
+namespace mp {
+
+static uint32_t float_to_raw(float value) noexcept
+{
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    return raw;
+}
+
+static float raw_to_float(uint32_t raw) noexcept
+{
+    float value;
+    memcpy(&value, &raw, sizeof(value));
+    return value;
+}
+
+/**
+ * Is the raw value within the limits of the parameter
+ */
+static bool is_valid(param_id_e id, uint32_t raw) noexcept
+{
+    const param_def_s& def = PARAM_DEFS[id];
+    switch (def.type) {
+    case mp_pb_ParamType_PARAM_TYPE_FLOAT: {
+        // Written this way so that NaN fails the check
+        const float value = raw_to_float(raw);
+        return value >= def.min && value <= def.max;
+    }
+    case mp_pb_ParamType_PARAM_TYPE_INT32: {
+        const int32_t value = static_cast<int32_t>(raw);
+        return value >= static_cast<int32_t>(def.min) && value <= static_cast<int32_t>(def.max);
+    }
+    case mp_pb_ParamType_PARAM_TYPE_BOOL:
+        return raw <= 1;
+    default:
+        return false;
+    }
+}
+
+static uint32_t get_default_raw(param_id_e id) noexcept
+{
+    const param_def_s& def = PARAM_DEFS[id];
+    switch (def.type) {
+    case mp_pb_ParamType_PARAM_TYPE_FLOAT:
+        return float_to_raw(def.default_value);
+    case mp_pb_ParamType_PARAM_TYPE_INT32:
+        return static_cast<uint32_t>(static_cast<int32_t>(def.default_value));
+    default:
+        return def.default_value != 0.f;
+    }
+}
+
+param_store& param_store::get_instance() noexcept
+{
+    return flight_context::get_current().get_param_store();
+}
+
+param_store::param_store() noexcept :
+    m_listeners{},
+    m_storage_device(nullptr)
+{
+    for (size_t i = 0; i < PARAM_COUNT; i++)
+        m_values[i].store(get_default_raw(static_cast<param_id_e>(i)), std::memory_order_relaxed);
+}
+
+bool param_store::set_float(param_id_e id, float value) noexcept
+{
+    if (PARAM_DEFS[id].type != mp_pb_ParamType_PARAM_TYPE_FLOAT || !is_valid(id, float_to_raw(value)))
+        return false;
+    store(id, float_to_raw(value));
+    return true;
+}
+
+bool param_store::set_int(param_id_e id, int32_t value) noexcept
+{
+    if (PARAM_DEFS[id].type != mp_pb_ParamType_PARAM_TYPE_INT32 || !is_valid(id, static_cast<uint32_t>(value)))
+        return false;
+    store(id, static_cast<uint32_t>(value));
+    return true;
+}
+
+bool param_store::set_bool(param_id_e id, bool value) noexcept
+{
+    if (PARAM_DEFS[id].type != mp_pb_ParamType_PARAM_TYPE_BOOL)
+        return false;
+    store(id, value ? 1 : 0);
+    return true;
+}
+
+void param_store::store(param_id_e id, uint32_t raw) noexcept
+{
+    const uint32_t previous = m_values[id].exchange(raw, std::memory_order_relaxed);
+    if (previous != raw && m_listeners[id])
+        m_listeners[id]->param_changed(id);
+}
+
+bool param_store::load() noexcept
+{
+    if (!m_storage_device)
+        return false;
+
+    uint8_t image[IMAGE_MAX_SIZE];
+    const ssize_t image_size = m_storage_device->read(reinterpret_cast<char*>(image), IMAGE_MAX_SIZE);
+    if (image_size < static_cast<ssize_t>(IMAGE_HEADER_SIZE + 2))
+        return false;
+
+    const size_t count = read_int<uint16_t>(image + 4);
+    const size_t data_size = IMAGE_HEADER_SIZE + count * IMAGE_RECORD_SIZE;
+    if (read_int<uint32_t>(image) != IMAGE_MAGIC || count > IMAGE_MAX_RECORDS || static_cast<size_t>(image_size) < data_size + 2)
+        return false;
+    if (crc16_ccitt(image, data_size) != read_int<uint16_t>(image + data_size))
+        return false;
+
+    const uint8_t* record = image + IMAGE_HEADER_SIZE;
+    for (size_t i = 0; i < count; i++, record += IMAGE_RECORD_SIZE) {
+        param_id_e id;
+        const uint32_t raw = read_int<uint32_t>(record + 4);
+        if (find(read_int<uint32_t>(record), id) && is_valid(id, raw))
+            store(id, raw);
+    }
+    return true;
+}
+
+bool param_store::save() noexcept
+{
+    if (!m_storage_device)
+        return false;
+
+    uint8_t image[IMAGE_MAX_SIZE];
+    uint8_t* out = image;
+    out = put_int<uint32_t>(out, IMAGE_MAGIC);
+    out = put_int<uint16_t>(out, static_cast<uint16_t>(PARAM_COUNT));
+    for (size_t i = 0; i < PARAM_COUNT; i++) {
+        out = put_int<uint32_t>(out, PARAM_DEFS[i].hash);
+        out = put_int<uint32_t>(out, get_raw(static_cast<param_id_e>(i)));
+    }
+    out = put_int<uint16_t>(out, crc16_ccitt(image, out - image));
+
+    const ssize_t size = out - image;
+    return m_storage_device->write(reinterpret_cast<const char*>(image), size) == size;
+}
+
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "param_defs.hpp"
+#include "util/hash.hpp"
+#include "pb/param.pb.h"
+#include <emblib/driver/char_dev.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace mp {
+
+using param_type_e = mp_pb_ParamType;
+
+enum param_id_e : size_t {
+#define MP_PARAM_ID(id, name, type, default_value, min, max) PARAM_##id,
+    MP_PARAM_TABLE(MP_PARAM_ID)
+#undef MP_PARAM_ID
+    PARAM_COUNT
+};
+
+struct param_def_s {
+    const char* name;
+    // Id of the parameter on the host, `fnv1a` of the name
+    uint32_t hash;
+    param_type_e type;
+    float default_value;
+    float min;
+    float max;
+};
+
+inline constexpr param_def_s PARAM_DEFS[PARAM_COUNT] = {
+#define MP_PARAM_DEF(id, name, type, default_value, min, max) \
+    {name, fnv1a(name), mp_pb_ParamType_PARAM_TYPE_##type, default_value, min, max},
+    MP_PARAM_TABLE(MP_PARAM_DEF)
+#undef MP_PARAM_DEF
+};
+
+/**
+ * Perfect hash from the parameter hash to its index, found at compile time
+ *
+ * There are twice as many slots as parameters rounded up to a power of 2,
+ * and the seed is the first one for which no two parameters share a slot.
+ */
+constexpr uint32_t param_get_slot_bits() noexcept
+{
+    uint32_t bits = 1;
+    while ((1u << bits) < 2 * PARAM_COUNT)
+        bits++;
+    return bits;
+}
+
+inline constexpr uint32_t PARAM_SLOT_BITS = param_get_slot_bits();
+inline constexpr size_t PARAM_SLOT_COUNT = 1u << PARAM_SLOT_BITS;
+inline constexpr uint8_t PARAM_SLOT_EMPTY = 0xFF;
+static_assert(PARAM_COUNT < PARAM_SLOT_EMPTY, "Too many parameters for the hash table");
+
+constexpr uint32_t param_get_slot(uint32_t hash, uint32_t seed) noexcept
+{
+    return ((hash ^ seed) * 0x9E3779B1u) >> (32 - PARAM_SLOT_BITS);
+}
+
+constexpr bool param_is_perfect_seed(uint32_t seed) noexcept
+{
+    bool used[PARAM_SLOT_COUNT] = {};
+    for (size_t i = 0; i < PARAM_COUNT; i++) {
+        const uint32_t slot = param_get_slot(PARAM_DEFS[i].hash, seed);
+        if (used[slot])
+            return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t param_find_seed() noexcept
+{
+    uint32_t seed = 0;
+    while (seed < 0x10000 && !param_is_perfect_seed(seed))
+        seed++;
+    return seed;
+}
+
+inline constexpr uint32_t PARAM_HASH_SEED = param_find_seed();
+static_assert(PARAM_HASH_SEED < 0x10000, "No perfect hash found, two parameter names probably have the same hash");
+
+struct param_slots_s {
+    uint8_t index[PARAM_SLOT_COUNT];
+};
+
+constexpr param_slots_s param_make_slots() noexcept
+{
+    param_slots_s slots {};
+    for (size_t i = 0; i < PARAM_SLOT_COUNT; i++)
+        slots.index[i] = PARAM_SLOT_EMPTY;
+    for (size_t i = 0; i < PARAM_COUNT; i++)
+        slots.index[param_get_slot(PARAM_DEFS[i].hash, PARAM_HASH_SEED)] = static_cast<uint8_t>(i);
+    return slots;
+}
+
+inline constexpr param_slots_s PARAM_SLOTS = param_make_slots();
+
+/**
+ * Notified when the value of the owned parameter changes
+ */
+class param_listener {
+
+public:
+    /**
+     * Called from the task which set the parameter
+     */
+    virtual void param_changed(param_id_e id) noexcept = 0;
+};
+
+/**
+ * Typed runtime parameters, defined in param_defs.hpp
+ *
+ * Values are kept as 32 bit words, so reading a parameter is a single
+ * atomic load indexed by its id, and can be done from any task. Parameters
+ * are looked up by their hash with a perfect hash table, so neither the
+ * hot path nor the commands ever compare names.
+ *
+ * Persistent image layout (little-endian):
+ * - uint32 magic (IMAGE_MAGIC)
+ * - uint16 number of records
+ * - for every parameter: uint32 hash, uint32 value
+ * - uint16 CRC-16/CCITT-FALSE of all the above
+ *
+ * Values with an unknown hash or out of the limits are skipped
+ * when loading, so the image survives adding and removing parameters.
+ */
+class param_store {
+
+public:
+    static constexpr uint32_t IMAGE_MAGIC = 0x5250504D; // "MPPR"
+    static constexpr size_t IMAGE_HEADER_SIZE = 6;
+    static constexpr size_t IMAGE_RECORD_SIZE = 8;
+    // Images written by other firmware versions can have a few more parameters
+    static constexpr size_t IMAGE_MAX_RECORDS = 2 * PARAM_COUNT;
+    static constexpr size_t IMAGE_MAX_SIZE = IMAGE_HEADER_SIZE + IMAGE_MAX_RECORDS * IMAGE_RECORD_SIZE + 2;
+
+    static param_store& get_instance() noexcept;
+
+    /**
+     * Find the parameter by its hash
+     * @returns false if there is no such parameter
+     */
+    static bool find(uint32_t hash, param_id_e& id) noexcept
+    {
+        const uint8_t index = PARAM_SLOTS.index[param_get_slot(hash, PARAM_HASH_SEED)];
+        if (index == PARAM_SLOT_EMPTY || PARAM_DEFS[index].hash != hash)
+            return false;
+        id = static_cast<param_id_e>(index);
+        return true;
+    }
+
+    /**
+     * Get the value with the type of the parameter
+     */
+    template <param_id_e id>
+    auto get() const noexcept
+    {
+        constexpr param_type_e type = PARAM_DEFS[id].type;
+        if constexpr (type == mp_pb_ParamType_PARAM_TYPE_FLOAT)
+            return get_float(id);
+        else if constexpr (type == mp_pb_ParamType_PARAM_TYPE_INT32)
+            return get_int(id);
+        else
+            return get_bool(id);
+    }
+
+    float get_float(param_id_e id) const noexcept
+    {
+        const uint32_t raw = get_raw(id);
+        float value;
+        memcpy(&value, &raw, sizeof(value));
+        return value;
+    }
+
+    int32_t get_int(param_id_e id) const noexcept
+    {
+        return static_cast<int32_t>(get_raw(id));
+    }
+
+    bool get_bool(param_id_e id) const noexcept
+    {
+        return get_raw(id) != 0;
+    }
+
+    uint32_t get_raw(param_id_e id) const noexcept
+    {
+        return m_values[id].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Set the value and notify the listener
+     * @returns false if the value is out of the limits or of the wrong type
+     */
+    bool set_float(param_id_e id, float value) noexcept;
+
+    bool set_int(param_id_e id, int32_t value) noexcept;
+
+    bool set_bool(param_id_e id, bool value) noexcept;
+
+    /**
+     * Set the listener notified of the changes of the parameter, `nullptr` to remove
+     * @note Should be set before the scheduler is started
+     */
+    void set_listener(param_id_e id, param_listener* listener) noexcept
+    {
+        m_listeners[id] = listener;
+    }
+
+    /**
+     * Set the device holding the persistent image
+     * @note Every read and write must start at the beginning
+     * of the image, like with a flash region
+     */
+    void set_storage_device(emblib::char_dev& storage_device) noexcept
+    {
+        m_storage_device = &storage_device;
+    }
+
+    /**
+     * Load the values from the persistent image
+     * @returns false if there is no storage device or no valid image
+     */
+    bool load() noexcept;
+
+    /**
+     * Write all the values to the persistent image
+     */
+    bool save() noexcept;
+
+private:
+    // Owned by the flight context
+    friend class flight_context;
+
+    param_store() noexcept;
+
+    /**
+     * Store the raw value of the parameter and notify its listener
+     */
+    void store(param_id_e id, uint32_t raw) noexcept;
+
+private:
+    std::atomic<uint32_t> m_values[PARAM_COUNT];
+    param_listener* m_listeners[PARAM_COUNT];
+    emblib::char_dev* m_storage_device;
+};
+
+}
@@ -0,0 +1,35 @@
+#include "accelerometer_channel.hpp"
+#include "params/param_store.hpp"
+#include "util/logger.hpp"
+
+namespace mp {
+
+accelerometer_channel::accelerometer_channel(
+    matrix_t transform,
+    vector_t bias,
+    float noise_density,
+    float sample_rate
+) :
+    three_axis_channel(noise_density, sample_rate),
+    m_bias(bias),
+    m_transform(transform)
+{
+    const param_store& params = param_store::get_instance();
+    // Disabled by 0, a cutoff at or above the Nyquist frequency is rejected
+    const float lpf_hz = params.get<PARAM_ACC_LPF_HZ>();
+    if (biquad_is_valid_frequency(get_sample_rate(), lpf_hz))
+        m_filter.set_section(0, biquad_lowpass(get_sample_rate(), lpf_hz));
+    else if (lpf_hz > 0.f)
+        MP_LOGS_WARNING(mp_pb_Subsystem_SUBSYSTEM_ACC, "Accelerometer low-pass above Nyquist, disabled Hz: ", lpf_hz);
+}
+
+accelerometer_channel::vector_t
+accelerometer_channel::process(const vector_t& raw_data) noexcept
+{
+    const vector_t corrected = m_transform.matmul(raw_data - m_bias);
+    float xyz[3] = {corrected(0), corrected(1), corrected(2)};
+    m_filter.process(xyz);
+    return vector_t {xyz[0], xyz[1], xyz[2]};
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "three_axis_channel.hpp"
+#include "tasks/task_config.hpp"
+#include "dsp/biquad.hpp"
+
+namespace mp {
+
+// TODO: Replace float data_type with m/s^2
+class accelerometer_channel : public three_axis_channel<float> {
+
+public:
+    explicit accelerometer_channel(
+        matrix_t transform,
+        vector_t bias,
+        float noise_density,
+        float sample_rate
+    );
+
+private:
+    vector_t process(const vector_t& raw_data) noexcept override;
+
+private:
+    vector_t m_bias;
+    matrix_t m_transform;
+    // Low-pass set up from the parameters on construction
+    biquad_cascade3<TASK_SENSOR_FILTER_SECTIONS> m_filter;
+};
+
+}
@@ -0,0 +1,74 @@
+#include "gyroscope_channel.hpp"
+#include "params/param_store.hpp"
+#include "util/logger.hpp"
+#include "util/time.hpp"
+
+namespace mp {
+
+static constexpr uint64_t DNOTCH_REPORT_PERIOD_US = std::chrono::microseconds(TASK_GYRO_DNOTCH_REPORT_PERIOD).count();
+
+gyroscope_channel::gyroscope_channel(
+    matrix_t transform,
+    float noise_density,
+    float sample_rate
+) :
+    three_axis_channel(noise_density, sample_rate),
+    m_transform(transform),
+    m_report_us(0)
+{
+    // Disabled filters are left out of the cascade instead of passing through,
+    // frequencies at or above the Nyquist frequency are rejected
+    const param_store& params = param_store::get_instance();
+    size_t section = 0;
+    const float lpf_hz = params.get<PARAM_GYRO_LPF_HZ>();
+    if (biquad_is_valid_frequency(get_sample_rate(), lpf_hz))
+        m_filter.set_section(section++, biquad_lowpass(get_sample_rate(), lpf_hz));
+    else if (lpf_hz > 0.f)
+        MP_LOGS_WARNING(mp_pb_Subsystem_SUBSYSTEM_GYRO, "Gyroscope low-pass above Nyquist, disabled Hz: ", lpf_hz);
+    const float notch_hz = params.get<PARAM_GYRO_NOTCH_HZ>();
+    if (biquad_is_valid_frequency(get_sample_rate(), notch_hz))
+        m_filter.set_section(section++, biquad_notch(get_sample_rate(), notch_hz, params.get<PARAM_GYRO_NOTCH_Q>()));
+    else if (notch_hz > 0.f)
+        MP_LOGS_WARNING(mp_pb_Subsystem_SUBSYSTEM_GYRO, "Gyroscope notch above Nyquist, disabled Hz: ", notch_hz);
+
+    m_dynamic_notch.configure(
+        get_sample_rate(),
+        params.get<PARAM_GYRO_DN_COUNT>(),
+        params.get<PARAM_GYRO_DN_MIN_HZ>(),
+        params.get<PARAM_GYRO_DN_MAX_HZ>(),
+        params.get<PARAM_GYRO_DN_Q>()
+    );
+}
+
+gyroscope_channel::vector_t
+gyroscope_channel::process(const vector_t& raw_data) noexcept
+{
+    const vector_t corrected = m_transform.matmul(raw_data);
+    float xyz[3] = {corrected(0), corrected(1), corrected(2)};
+    m_filter.process(xyz);
+    m_dynamic_notch.process(xyz);
+
+    if (m_dynamic_notch.get_notch_count() > 0) {
+        const uint64_t start_ns = get_time_ns();
+        m_dynamic_notch.step();
+        m_step_stats.add(static_cast<float>(get_time_ns() - start_ns));
+        report_dynamic_notch(start_ns / 1000);
+    }
+    return vector_t {xyz[0], xyz[1], xyz[2]};
+}
+
+void gyroscope_channel::report_dynamic_notch(uint64_t now_us) noexcept
+{
+    if (now_us - m_report_us < DNOTCH_REPORT_PERIOD_US)
+        return;
+    m_report_us = now_us;
+
+    for (size_t i = 0; i < m_dynamic_notch.get_notch_count(); i++)
+        MP_LOGS_INFO(mp_pb_Subsystem_SUBSYSTEM_GYRO, "Dynamic notch Hz: ", m_dynamic_notch.get_frequency(i));
+
+    const auto stats = m_step_stats.take();
+    MP_LOGS_INFO(mp_pb_Subsystem_SUBSYSTEM_GYRO, "Dynamic notch step mean ns: ", stats.get_mean()(0));
+    MP_LOGS_INFO(mp_pb_Subsystem_SUBSYSTEM_GYRO, "Dynamic notch step max ns: ", stats.get_max()(0));
+}
+
+}
\ No newline at end of file
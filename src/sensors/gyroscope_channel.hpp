@@ -0,0 +1,39 @@
+#pragma once
+
+#include "three_axis_channel.hpp"
+#include "tasks/task_config.hpp"
+#include "dsp/biquad.hpp"
+#include "dsp/dynamic_notch.hpp"
+
+namespace mp {
+
+// TODO: Replace float data_type with rad/s
+class gyroscope_channel : public three_axis_channel<float> {
+
+public:
+    explicit gyroscope_channel(
+        matrix_t transform,
+        float noise_density,
+        float sample_rate
+    );
+
+private:
+    vector_t process(const vector_t& raw_data) noexcept override;
+
+    /**
+     * Log the frequencies of the dynamic notches and the cost of their analysis
+     */
+    void report_dynamic_notch(uint64_t now_us) noexcept;
+
+private:
+    matrix_t m_transform;
+    // Low-pass and notch set up from the parameters on construction
+    biquad_cascade3<TASK_SENSOR_FILTER_SECTIONS> m_filter;
+    // Applied after the filter, the analysis advances one step per sample
+    dynamic_notch<TASK_GYRO_FFT_SIZE, TASK_GYRO_DNOTCH_MAX_COUNT> m_dynamic_notch;
+    // Time of an analysis step in ns
+    running_stats<float, 1> m_step_stats;
+    uint64_t m_report_us;
+};
+
+}
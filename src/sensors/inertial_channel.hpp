@@ -0,0 +1,90 @@
+#pragma once
+
+#include "accelerometer_channel.hpp"
+#include "gyroscope_channel.hpp"
+#include <emblib/rtos/mutex.hpp>
+
+namespace mp {
+
+/**
+ * Corrected accelerometer and gyroscope values read by the state estimator
+ *
+ * The IMU task reads both sensors at once and publishes them through here,
+ * which stores the corrected values in their channels and together as
+ * a pair, so a reader never gets the acceleration of one read with the
+ * angular velocity of another. Without the IMU the sensors are read by
+ * separate tasks at their own rates, and the pair is made of the latest
+ * values of the two channels.
+ */
+class inertial_channel {
+
+public:
+    /**
+     * Values of both sensors and the time at which they were read
+     */
+    struct sample_s {
+        vector3f acceleration;
+        vector3f angular_velocity;
+        // See `get_time_us`, of the gyroscope without the IMU
+        uint64_t timestamp_us;
+    };
+
+    explicit inertial_channel(accelerometer_channel& accelerometer, gyroscope_channel& gyroscope) noexcept :
+        m_accelerometer(accelerometer),
+        m_gyroscope(gyroscope),
+        m_paired(false)
+    {}
+
+    inertial_channel(const inertial_channel&) = delete;
+    inertial_channel& operator=(const inertial_channel&) = delete;
+
+    accelerometer_channel& get_accelerometer() noexcept
+    {
+        return m_accelerometer;
+    }
+
+    gyroscope_channel& get_gyroscope() noexcept
+    {
+        return m_gyroscope;
+    }
+
+    /**
+     * Publish the raw values of a single read to both channels and the pair
+     * @note Called only by the IMU task
+     */
+    void publish(const vector3f& acceleration_raw, const vector3f& angular_velocity_raw, uint64_t timestamp_us) noexcept
+    {
+        const vector3f acceleration = m_accelerometer.publish(acceleration_raw, timestamp_us);
+        const vector3f angular_velocity = m_gyroscope.publish(angular_velocity_raw, timestamp_us);
+
+        emblib::scoped_lock lock{m_pair_mutex};
+        m_pair = {acceleration, angular_velocity, timestamp_us};
+        m_paired = true;
+    }
+
+    /**
+     * Get the latest corrected values of both sensors
+     */
+    sample_s get_corrected_sample() noexcept
+    {
+        {
+            emblib::scoped_lock lock{m_pair_mutex};
+            if (m_paired)
+                return m_pair;
+        }
+
+        const gyroscope_channel::sample_s gyroscope_sample = m_gyroscope.get_corrected_sample();
+        return {m_accelerometer.get_corrected(), gyroscope_sample.value, gyroscope_sample.timestamp_us};
+    }
+
+private:
+    accelerometer_channel& m_accelerometer;
+    gyroscope_channel& m_gyroscope;
+
+    emblib::mutex m_pair_mutex;
+    sample_s m_pair;
+    // Set once the IMU task publishes
+    bool m_paired;
+};
+
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "util/math.hpp"
+#include "util/running_stats.hpp"
+#include <emblib/rtos/mutex.hpp>
+
+namespace mp {
+
+/**
+ * Processed values of a three axis sensor, shared between the task
+ * which reads the sensor and the tasks which use the values
+ * Allows for raw data correction through the `process` method
+ *
+ * Values are published by a reading task, either the task of the
+ * sensor itself or the IMU task which reads two sensors at once.
+ */
+template <typename data_type>
+class three_axis_channel {
+
+public:
+    using vector_t = vector<data_type, 3>;
+    using matrix_t = matrix<data_type, 3>;
+    using stats_t = running_stats<data_type, 3>;
+
+    /**
+     * Value together with the time at which it was read
+     */
+    struct sample_s {
+        vector_t value;
+        // See `get_time_us`
+        uint64_t timestamp_us;
+    };
+
+    /**
+     * @param noise_density Of the sensor, in data_type/sqrt(Hz)
+     * @param sample_rate Rate at which the values are published in Hz
+     */
+    explicit three_axis_channel(float noise_density, float sample_rate) noexcept :
+        m_noise_density(noise_density),
+        m_sample_rate(sample_rate)
+    {}
+
+    three_axis_channel(const three_axis_channel&) = delete;
+    three_axis_channel& operator=(const three_axis_channel&) = delete;
+
+    /**
+     * Process the raw value and make it the last one
+     * @note Called only by the reading task
+     * @returns The corrected value
+     */
+    vector_t publish(const vector_t& raw, uint64_t timestamp_us) noexcept
+    {
+        // Processing state belongs to the reading task, so the readers
+        // only wait for the result to be stored and not for the filters
+        const vector_t corrected = process(raw);
+
+        emblib::scoped_lock lock{m_read_mutex};
+        m_last_timestamp_us = timestamp_us;
+        m_last_raw = raw;
+        m_last_corrected = corrected;
+        // Updated on every value so the statistics cover every sample
+        m_raw_stats.add(m_last_raw);
+        m_corrected_stats.add(m_last_corrected);
+        return corrected;
+    }
+
+    /**
+     * Get last read raw value
+     */
+    vector_t get_raw() noexcept
+    {
+        emblib::scoped_lock lock{m_read_mutex};
+        return m_last_raw;
+    }
+
+    /**
+     * Get last corrected value
+     */
+    vector_t get_corrected() noexcept
+    {
+        emblib::scoped_lock lock{m_read_mutex};
+        return m_last_corrected;
+    }
+
+    /**
+     * Get last corrected value and its acquisition time
+     */
+    sample_s get_corrected_sample() noexcept
+    {
+        emblib::scoped_lock lock{m_read_mutex};
+        return {m_last_corrected, m_last_timestamp_us};
+    }
+
+    /**
+     * Get the statistics of the raw values since the previous call
+     */
+    stats_t take_raw_stats() noexcept
+    {
+        emblib::scoped_lock lock{m_read_mutex};
+        return m_raw_stats.take();
+    }
+
+    /**
+     * Get the statistics of the corrected values since the previous call
+     */
+    stats_t take_corrected_stats() noexcept
+    {
+        emblib::scoped_lock lock{m_read_mutex};
+        return m_corrected_stats.take();
+    }
+
+    /**
+     * Get the noise variance matrix based on the sensor noise
+     * density and the sampling frequency
+     * TODO: Change the matrix scalar type to data_type/sqrt(Hz)
+     */
+    matrix3f get_noise_variance() const noexcept
+    {
+        const float noise_variance = m_sample_rate * m_noise_density * m_noise_density;
+        return matrix3f::diagonal(noise_variance);
+    }
+
+    /**
+     * Rate at which the values are published in Hz
+     */
+    float get_sample_rate() const noexcept
+    {
+        return m_sample_rate;
+    }
+
+    /// @todo Add calculate_bias method
+
+private:
+    /**
+     * Apply processing to the raw input value
+     * This can be a filter, bias subtraction, ...
+     * @note Runs in the reading task without holding the read lock
+     */
+    virtual vector_t process(const vector_t& raw_data) noexcept = 0;
+
+private:
+    float m_noise_density;
+    float m_sample_rate;
+
+    emblib::mutex m_read_mutex;
+    vector_t m_last_raw;
+    vector_t m_last_corrected;
+    uint64_t m_last_timestamp_us = 0;
+    stats_t m_raw_stats;
+    stats_t m_corrected_stats;
+};
+
+}
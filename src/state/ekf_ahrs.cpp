@@ -1,5 +1,7 @@
 #include "ekf_ahrs.hpp"
+#include "params/param_store.hpp"
 #include "util/constants.hpp"
+#include "util/trace.hpp"
 
 namespace mp {
 
@@ -10,6 +12,7 @@ ekf_ahrs::ekf_ahrs() noexcept :
 void
 ekf_ahrs::update(const sensor_data_s& input, float dt) noexcept
 {
+    MP_TRACE_SCOPE("ekf update");
     // TODO: Validate accel and gyro input not nullptr
     const vector3f a_in = *input.accelerometer;
     const vector3f w_in = *input.gyroscope;
@@ -24,10 +27,11 @@ ekf_ahrs::update(const sensor_data_s& input, float dt) noexcept
     R.set_submatrix(3, 3, *input.gyroscope_cov);
 
     // TODO: Assign values using the kalman_state_e
-    constexpr float a_noise = 5e-1;
-    constexpr float q_noise = 1e-1;
-    constexpr float w_noise = 5e-1;
-    constexpr float wd_noise = 1e-1;
+    const param_store& params = param_store::get_instance();
+    const float a_noise = params.get<PARAM_EKF_A_NOISE>();
+    const float q_noise = params.get<PARAM_EKF_Q_NOISE>();
+    const float w_noise = params.get<PARAM_EKF_W_NOISE>();
+    const float wd_noise = params.get<PARAM_EKF_WD_NOISE>();
     const auto Q = vectorf<KALMAN_DIM>({
         a_noise, a_noise, a_noise,
         q_noise, q_noise, q_noise, q_noise,
@@ -1,5 +1,7 @@
 #include "ekf_inertial.hpp"
+#include "params/param_store.hpp"
 #include "util/constants.hpp"
+#include "util/trace.hpp"
 
 namespace mp {
 
@@ -11,6 +13,7 @@ ekf_inertial::ekf_inertial(const ekf_vehicle& vehicle) noexcept :
 void
 ekf_inertial::update(const sensor_data_s& input, float dt) noexcept
 {
+    MP_TRACE_SCOPE("ekf update");
     // TODO: Validate accel and gyro input not nullptr
     const vector3f a_in = *input.accelerometer;
     const vector3f w_in = *input.gyroscope;
@@ -25,11 +28,12 @@ ekf_inertial::update(const sensor_data_s& input, float dt) noexcept
     R.set_submatrix(3, 3, *input.gyroscope_cov);
 
     // TODO: Get Q from the vehicle
-    constexpr float v_noise = 1;
-    constexpr float a_noise = 5e-1;
-    constexpr float q_noise = 1e-1;
-    constexpr float w_noise = 5e-1;
-    constexpr float wd_noise = 1e-1;
+    const param_store& params = param_store::get_instance();
+    const float v_noise = params.get<PARAM_EKF_V_NOISE>();
+    const float a_noise = params.get<PARAM_EKF_A_NOISE>();
+    const float q_noise = params.get<PARAM_EKF_Q_NOISE>();
+    const float w_noise = params.get<PARAM_EKF_W_NOISE>();
+    const float wd_noise = params.get<PARAM_EKF_WD_NOISE>();
     const auto Q = vectorf<KALMAN_DIM>({
         v_noise, v_noise, v_noise,
         a_noise, a_noise, a_noise,
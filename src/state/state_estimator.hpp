@@ -1,6 +1,7 @@
 #pragma once
 
 #include "util/math.hpp"
+#include <cstdint>
 
 namespace mp {
 
@@ -33,6 +34,9 @@ struct state_s {
     vector3f angular_velocity {0, 0, 0};
     // Quaternion which maps the local frame to the global frame
     quaternionf rotationq {1, 0, 0, 0};
+    // Acquisition time (see `get_time_us`) of the gyroscope sample the
+    // state is based on, used to measure the age of the data behind control
+    uint64_t timestamp_us {0};
 };
 
 /**
@@ -0,0 +1,139 @@
+#include "task.hpp"
+#include "util/logger.hpp"
+#include "util/time.hpp"
+#include <cstdio>
+
+namespace mp {
+
+void task::register_task() noexcept
+{
+    // Tasks are created before the scheduler is started, so no locking
+    const bool registered = m_context.add_task(*this);
+    assert(registered);
+    UNUSED(registered);
+}
+
+void task::run() noexcept
+{
+    flight_context::set_current(&m_context);
+    run_task();
+}
+
+task_timing_s task::take_timing() noexcept
+{
+    task_timing_s timing {};
+    m_published.read(timing);
+    // Window is restarted by the task at the end of its next iteration
+    m_take_requested.store(true, std::memory_order_relaxed);
+    return timing;
+}
+
+void task::sleep_periodic(emblib::ticks_t period) noexcept
+{
+    const uint32_t period_us = std::chrono::duration_cast<std::chrono::microseconds>(period).count();
+
+    // Initialization before the first sleep is not an iteration
+    if (m_measuring)
+        end_iteration(period_us);
+    emblib::task::sleep_periodic(period);
+
+    // Each wake up should be exactly one period after the previous
+    // one, unless the task fell behind and the schedule was reset
+    const uint64_t now_us = get_time_us();
+    m_expected_start_us = m_measuring ? m_expected_start_us + period_us : now_us;
+    if (now_us >= m_expected_start_us + period_us)
+        m_expected_start_us = now_us;
+    begin_iteration(m_expected_start_us);
+}
+
+void task::begin_iteration(uint64_t scheduled_us) noexcept
+{
+    m_measuring = true;
+    m_iteration_start_us = get_time_us();
+#if MP_TRACE
+    m_trace_ring.set_current();
+    m_iteration_start_ns = get_time_ns();
+#endif
+    m_iteration_jitter_us = m_iteration_start_us > scheduled_us ? m_iteration_start_us - scheduled_us : 0;
+}
+
+void task::end_iteration(uint32_t period_us) noexcept
+{
+    const uint32_t exec_us = get_time_us() - m_iteration_start_us;
+#if MP_TRACE
+    m_trace_ring.push("iteration", m_iteration_start_ns, get_time_ns());
+#endif
+
+    if (m_take_requested.load(std::memory_order_relaxed)) {
+        m_take_requested.store(false, std::memory_order_relaxed);
+        m_window_exec_sum_us = 0;
+        m_window_iterations = 0;
+        m_timing.exec_max_us = 0;
+        m_timing.jitter_max_us = 0;
+    }
+
+    m_window_exec_sum_us += exec_us;
+    m_window_iterations++;
+
+    m_timing.iterations++;
+    m_timing.deadline_misses += period_us > 0 && exec_us > period_us;
+    m_timing.period_us = period_us;
+    m_timing.exec_mean_us = m_window_exec_sum_us / m_window_iterations;
+    m_timing.exec_max_us = exec_us > m_timing.exec_max_us ? exec_us : m_timing.exec_max_us;
+    m_timing.jitter_max_us = m_iteration_jitter_us > m_timing.jitter_max_us ? m_iteration_jitter_us : m_timing.jitter_max_us;
+    m_published.write(m_timing);
+}
+
+void task::log_timing_report() noexcept
+{
+    for (size_t i = 0; i < get_task_count(); i++) {
+        task& registered_task = get_task(i);
+        const task_timing_s timing = registered_task.take_timing();
+        log_info(
+            registered_task.get_name(), ": iterations ", timing.iterations,
+            ", deadline misses ", timing.deadline_misses,
+            ", exec mean ", timing.exec_mean_us, "us max ", timing.exec_max_us,
+            "us (period ", timing.period_us, "us), jitter max ", timing.jitter_max_us, "us"
+        );
+    }
+}
+
+bool task::write_trace_json(emblib::char_dev& output) noexcept
+{
+#if MP_TRACE
+    char buffer[160];
+    auto write = [&output, &buffer](int size) {
+        return size > 0 && static_cast<size_t>(size) < sizeof(buffer) && output.write(buffer, size) == size;
+    };
+
+    bool status = write(snprintf(buffer, sizeof(buffer), "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"));
+    for (size_t i = 0; i < get_task_count() && status; i++) {
+        const task& registered_task = get_task(i);
+        // Every task is shown as a thread of a single process
+        status = write(snprintf(
+            buffer, sizeof(buffer),
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            i > 0 ? ",\n" : "", static_cast<unsigned>(i), registered_task.get_name()
+        ));
+
+        // Complete events with the time stamps in microseconds
+        const trace_ring& ring = registered_task.m_trace_ring;
+        for (size_t j = 0; j < ring.get_count() && status; j++) {
+            const trace_event_s& event = ring.get_event(j);
+            status = write(snprintf(
+                buffer, sizeof(buffer),
+                ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%03u,\"dur\":%u.%03u}",
+                event.name, static_cast<unsigned>(i),
+                static_cast<unsigned long long>(event.begin_ns / 1000), static_cast<unsigned>(event.begin_ns % 1000),
+                static_cast<unsigned>(event.duration_ns / 1000), static_cast<unsigned>(event.duration_ns % 1000)
+            ));
+        }
+    }
+    return status && write(snprintf(buffer, sizeof(buffer), "\n]}\n"));
+#else
+    UNUSED(output);
+    return true;
+#endif
+}
+
+}
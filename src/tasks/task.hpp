@@ -0,0 +1,159 @@
+#pragma once
+
+#include "task_config.hpp"
+#include "flight_context.hpp"
+#include "util/seqlock.hpp"
+#include "util/trace.hpp"
+#include <emblib/driver/char_dev.hpp>
+#include <emblib/rtos/task.hpp>
+#include <atomic>
+#include <cstdint>
+
+namespace mp {
+
+/**
+ * Execution timing of a task, see `task::take_timing`
+ *
+ * Counters are totals since the start, while the mean and the
+ * worst cases cover only the iterations since the previous take.
+ */
+struct task_timing_s {
+    uint32_t iterations;
+    uint32_t deadline_misses;
+    uint32_t period_us;
+    uint32_t exec_mean_us;
+    uint32_t exec_max_us;
+    // Delay of the start of an iteration after its scheduled time
+    uint32_t jitter_max_us;
+};
+
+/**
+ * Base of all the minipilot tasks which measures how long each iteration runs
+ *
+ * Periodic tasks are measured by `sleep_periodic`, which hides the one of
+ * `emblib::task`, so they don't need any changes: the time from waking up
+ * to the next `sleep_periodic` is the execution time, the wake up delay is
+ * the jitter, and an iteration longer than the period is a deadline miss.
+ * Tasks with their own scheduling mark the iterations with `begin_iteration`
+ * and `end_iteration` instead, and event driven tasks without a deadline
+ * only get the execution time. Execution time is the wall time of the
+ * iteration, so it includes preemption and blocking.
+ *
+ * Every task is registered on construction in the current flight context,
+ * so the timing of all the tasks can be sent as telemetry, and makes that
+ * context current for its thread before `run_task`. With `MP_TRACE` each
+ * task also has its own trace ring, made current for its thread at the
+ * start of every iteration, in which the iterations and the
+ * `MP_TRACE_SCOPE`s are recorded.
+ */
+class task : public emblib::task {
+
+public:
+    template <typename priority_type, typename stack_type>
+    task(const char* name, priority_type priority, stack_type& stack) noexcept :
+        emblib::task(name, priority, stack),
+        m_context(flight_context::get_current()),
+        m_name(name),
+        m_measuring(false),
+        m_iteration_start_us(0),
+        m_iteration_jitter_us(0),
+        m_expected_start_us(0),
+        m_window_exec_sum_us(0),
+        m_window_iterations(0),
+        m_timing {},
+        m_take_requested(false)
+    {
+        register_task();
+    }
+
+    const char* get_name() const noexcept
+    {
+        return m_name;
+    }
+
+    /**
+     * Get the timing and start a new window for the mean and the worst cases
+     * @note Can be called from any task
+     */
+    task_timing_s take_timing() noexcept;
+
+    /**
+     * Number of tasks created so far in the current flight context
+     */
+    static size_t get_task_count() noexcept
+    {
+        return flight_context::get_current().get_task_count();
+    }
+
+    static task& get_task(size_t index) noexcept
+    {
+        return flight_context::get_current().get_task(index);
+    }
+
+    /**
+     * Log the timing of all the tasks of the current flight
+     * context, used as a summary at the end of host runs
+     */
+    static void log_timing_report() noexcept;
+
+    /**
+     * Write the trace rings of all the tasks as Chrome trace event JSON,
+     * which can be opened with Perfetto or chrome://tracing
+     * @note Should only be called once the tasks are stopped, does
+     * nothing unless built with `MP_TRACE`
+     * @returns false if writing to the output failed
+     */
+    static bool write_trace_json(emblib::char_dev& output) noexcept;
+
+protected:
+    /**
+     * Body of the task, runs with the flight context of the task
+     */
+    virtual void run_task() noexcept = 0;
+
+    /**
+     * Sleep until the next period and measure the iteration
+     */
+    void sleep_periodic(emblib::ticks_t period) noexcept;
+
+    /**
+     * Mark the start of an iteration
+     * @param scheduled_us Time at which it should have started, for the jitter
+     */
+    void begin_iteration(uint64_t scheduled_us) noexcept;
+
+    /**
+     * Mark the end of an iteration which should complete within
+     * the period, 0 if the iteration has no deadline
+     */
+    void end_iteration(uint32_t period_us) noexcept;
+
+private:
+    void run() noexcept final;
+
+    void register_task() noexcept;
+
+private:
+    flight_context& m_context;
+    const char* m_name;
+
+    // Written only by the task itself
+    bool m_measuring;
+    uint64_t m_iteration_start_us;
+    uint32_t m_iteration_jitter_us;
+    uint64_t m_expected_start_us;
+    uint64_t m_window_exec_sum_us;
+    uint32_t m_window_iterations;
+    task_timing_s m_timing;
+
+    // Published after every iteration for the readers
+    seqlock<task_timing_s> m_published;
+    std::atomic<bool> m_take_requested;
+
+#if MP_TRACE
+    trace_ring m_trace_ring;
+    uint64_t m_iteration_start_ns = 0;
+#endif
+};
+
+}
@@ -2,27 +2,31 @@
 
 #include "task_config.hpp"
 #include "task_three_axis_sensor.hpp"
+#include "sensors/accelerometer_channel.hpp"
 #include <emblib/driver/accelerometer.hpp>
 
 namespace mp {
 
-// TODO: Replace float data_type with m/s^2
-class task_accelerometer : public task_three_axis_sensor<float> {
+/**
+ * Task reading the accelerometer when it isn't read by the IMU task
+ */
+class task_accelerometer : public task_three_axis_sensor<float, mp_pb_Subsystem_SUBSYSTEM_ACC> {
 
 public:
     explicit task_accelerometer(
         emblib::accelerometer& accelerometer,
-        matrix_t transform,
-        vector_t bias
-    );
-
-private:
-    vector_t process(const vector_t& raw_data) const noexcept override;
-
-private:
-    vector_t m_bias;
-    matrix_t m_transform;
-    // TODO: Add low-pass filter
+        accelerometer_channel& channel,
+        three_axis_fifo<float>* fifo
+    ) :
+        task_three_axis_sensor(
+            accelerometer,
+            channel,
+            "Task accelerometer",
+            TASK_ACCEL_PRIORITY,
+            TASK_ACCEL_PERIOD,
+            fifo
+        )
+    {}
 };
 
-}
\ No newline at end of file
+}
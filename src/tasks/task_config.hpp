@@ -16,19 +16,49 @@ enum task_priority_e : size_t {
 
 // Stack and buffer sizes are in bytes
 
-inline constexpr size_t             TASK_LOGGER_QUEUE_SIZE      = 8;
+inline constexpr size_t             TASK_MAX_COUNT              = 12; // Registered for the timing telemetry
+
+inline constexpr size_t             TASK_LOGGER_RING_SIZE       = 2048; // Power of 2
+inline constexpr auto               TASK_LOGGER_PERIOD          = std::chrono::milliseconds(20);
+inline constexpr auto               TASK_LOGGER_DROP_REPORT_PERIOD = std::chrono::seconds(5);
 inline constexpr size_t             TASK_LOGGER_STACK_SIZE      = 1024;
 inline constexpr task_priority_e    TASK_LOGGER_PRIORITY        = TASK_PRIORITY_VERY_LOW;
 
+inline constexpr size_t             TASK_TRANSMITTER_STACK_SIZE = 1024;
+inline constexpr size_t             TASK_TRANSMITTER_BUFFER_SIZE = 512;
+inline constexpr task_priority_e    TASK_TRANSMITTER_PRIORITY   = TASK_PRIORITY_MEDIUM;
+inline constexpr auto               TASK_TRANSMITTER_WRITE_TIMEOUT = std::chrono::milliseconds(100); // Sync output devices only
+
 inline constexpr size_t             TASK_TELEMETRY_STACK_SIZE   = 1024;
 inline constexpr task_priority_e    TASK_TELEMETRY_PRIORITY     = TASK_PRIORITY_LOW;
-inline constexpr auto               TASK_TELEMETRY_PERIOD       = std::chrono::milliseconds(200); // 5Hz
+inline constexpr auto               TASK_TELEMETRY_PERIOD       = std::chrono::milliseconds(10); // 100Hz, fastest stream rate
+inline constexpr size_t             TASK_TELEMETRY_FRAME_BUDGET = 160; // Max encoded frame size per period
+inline constexpr float              TASK_TELEMETRY_DEFAULT_RATE = 5.f; // Hz, initial rate of every stream
+inline constexpr size_t             TASK_TELEMETRY_COMPACT_MAX_SAMPLES = 8; // Per compact frame
+inline constexpr auto               TASK_TELEMETRY_COMPACT_MAX_LATENCY = std::chrono::milliseconds(100);
 
 inline constexpr task_priority_e    TASK_ACCEL_PRIORITY         = TASK_PRIORITY_REALTIME;
 inline constexpr auto               TASK_ACCEL_PERIOD           = std::chrono::milliseconds(5); // 200Hz
 
 inline constexpr task_priority_e    TASK_GYRO_PRIORITY          = TASK_PRIORITY_REALTIME;
 inline constexpr auto               TASK_GYRO_PERIOD            = std::chrono::milliseconds(5); // 200Hz
+// Biquad sections available for filtering each sensor
+inline constexpr size_t             TASK_SENSOR_FILTER_SECTIONS = 4;
+// Sensors with a FIFO are read in bursts and decimated to the task rate
+inline constexpr size_t             TASK_SENSOR_FIFO_MAX_BURST  = 64; // Samples per wake-up, the rest wait for the next
+inline constexpr size_t             TASK_SENSOR_MAX_DECIMATION  = 40; // 8kHz output data rate at 200Hz
+inline constexpr size_t             TASK_SENSOR_DECIMATION_TAPS = 4; // Per output sample, delays the output by half as many task periods
+// Samples analyzed by the dynamic notch of the gyroscope, the frequency resolution is the rate divided by it
+inline constexpr size_t             TASK_GYRO_FFT_SIZE          = 64; // Power of 2
+inline constexpr size_t             TASK_GYRO_DNOTCH_MAX_COUNT  = 3;
+inline constexpr auto               TASK_GYRO_DNOTCH_REPORT_PERIOD = std::chrono::seconds(10);
+
+// Replaces the accelerometer and gyroscope tasks if the IMU is provided, runs at its output data rate
+// which must be the gyroscope task rate, within the tolerance
+inline constexpr size_t             TASK_IMU_STACK_SIZE         = 1024;
+inline constexpr task_priority_e    TASK_IMU_PRIORITY           = TASK_PRIORITY_REALTIME;
+inline constexpr auto               TASK_IMU_DATA_READY_TIMEOUT = std::chrono::milliseconds(10); // Read anyway after this
+inline constexpr float              TASK_IMU_RATE_TOLERANCE     = 0.01f; // Relative to the rate
 
 inline constexpr size_t             TASK_STATE_STACK_SIZE       = 24576;
 inline constexpr task_priority_e    TASK_STATE_PRIORITY         = TASK_PRIORITY_REALTIME;
@@ -36,10 +66,15 @@ inline constexpr auto               TASK_STATE_PERIOD           = std::chrono::m
 
 inline constexpr size_t             TASK_RECEIVER_STACK_SIZE    = 1024;
 inline constexpr size_t             TASK_RECEIVER_QUEUE_SIZE    = 4;
+inline constexpr size_t             TASK_RECEIVER_RING_SIZE     = 512; // Power of 2
+inline constexpr size_t             TASK_RECEIVER_READ_CHUNK    = 64; // Max size of a single read
 inline constexpr task_priority_e    TASK_RECEIVER_PRIORITY      = TASK_PRIORITY_HIGH;
 
 inline constexpr size_t             TASK_VEHICLE_STACK_SIZE     = 4096;
 inline constexpr task_priority_e    TASK_VEHICLE_PRIORITY       = TASK_PRIORITY_HIGH;
-inline constexpr auto               TASK_VEHICLE_PERIOD         = std::chrono::milliseconds(50); // 20Hz
+// Vehicle period is the vehicle.period_ms parameter
+inline constexpr size_t             TASK_VEHICLE_ACK_QUEUE_SIZE = 8; // Acks waiting to be sent
+inline constexpr bool               TASK_VEHICLE_WAKE_ON_COMMAND = true; // Else commands wait for the next period
+inline constexpr auto               TASK_VEHICLE_LATENCY_REPORT_PERIOD = std::chrono::seconds(10);
 
 }
\ No newline at end of file
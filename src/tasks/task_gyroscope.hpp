@@ -2,25 +2,31 @@
 
 #include "task_config.hpp"
 #include "task_three_axis_sensor.hpp"
+#include "sensors/gyroscope_channel.hpp"
 #include <emblib/driver/gyroscope.hpp>
 
 namespace mp {
 
-// TODO: Replace float data_type with rad/s
-class task_gyroscope : public task_three_axis_sensor<float> {
+/**
+ * Task reading the gyroscope when it isn't read by the IMU task
+ */
+class task_gyroscope : public task_three_axis_sensor<float, mp_pb_Subsystem_SUBSYSTEM_GYRO> {
 
 public:
     explicit task_gyroscope(
         emblib::gyroscope& gyroscope,
-        matrix_t transform
-    );
-
-private:
-    vector_t process(const vector_t& raw_data) const noexcept override;
-
-private:
-    matrix_t m_transform;
-    // TODO: Add band-pass filter
+        gyroscope_channel& channel,
+        three_axis_fifo<float>* fifo
+    ) :
+        task_three_axis_sensor(
+            gyroscope,
+            channel,
+            "Task gyroscope",
+            TASK_GYRO_PRIORITY,
+            TASK_GYRO_PERIOD,
+            fifo
+        )
+    {}
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,45 @@
+#include "task_imu.hpp"
+#include "util/logger.hpp"
+#include "util/time.hpp"
+#include "util/trace.hpp"
+
+namespace mp {
+
+void task_imu::run_task() noexcept
+{
+    // Availability is checked before the task is created, a failure here leaves the timeout pacing the reads
+    if (!m_imu.set_data_ready_callback([this]() { notify_from_isr(); })) {
+        MP_LOGS_ERROR(mp_pb_Subsystem_SUBSYSTEM_IMU, "IMU data ready callback not set");
+    }
+
+    while (true) {
+        if (!wait_notification(TASK_IMU_DATA_READY_TIMEOUT)) {
+            MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_IMU, std::chrono::seconds(1), "IMU data ready timed out");
+        }
+
+        // Paced by the IMU, so the iterations have no deadline
+        begin_iteration(get_time_us());
+        read_sensors();
+        end_iteration(0);
+    }
+}
+
+void task_imu::read_sensors() noexcept
+{
+    MP_TRACE_SCOPE("imu read");
+    float accelerometer[3];
+    float gyroscope[3];
+    // Taken before the read, so the age of the data includes the bus transfer
+    const uint64_t timestamp_us = get_time_us();
+    if (!m_imu.read_imu(accelerometer, gyroscope)) {
+        MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_IMU, std::chrono::seconds(1), "IMU reading failed");
+        return;
+    }
+    m_inertial.publish(
+        {accelerometer[0], accelerometer[1], accelerometer[2]},
+        {gyroscope[0], gyroscope[1], gyroscope[2]},
+        timestamp_us
+    );
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "task.hpp"
+#include "task_config.hpp"
+#include "drivers/imu.hpp"
+#include "sensors/inertial_channel.hpp"
+
+namespace mp {
+
+/**
+ * Task reading both sensors of an IMU, replacing the accelerometer and gyroscope tasks
+ *
+ * Wakes up on the data ready interrupt of the chip, reads the accelerometer
+ * and the gyroscope in one transaction and publishes both values with the
+ * same timestamp as a pair. If the interrupt doesn't arrive in time the sensors
+ * are read anyway, so a missed interrupt only delays the sample.
+ *
+ * Every sample is published without a FIFO or decimation, so the output
+ * data rate of the IMU must be configured to the rate of the gyroscope
+ * task, which the channels and their filters are set up for. IMUs without
+ * the interrupt or with another rate are read by the separate sensor tasks.
+ */
+class task_imu : public task {
+
+public:
+    /**
+     * @note The IMU must have the data ready interrupt
+     */
+    explicit task_imu(
+        imu& imu,
+        inertial_channel& inertial
+    ) noexcept :
+        task("Task IMU", TASK_IMU_PRIORITY, m_task_stack),
+        m_imu(imu),
+        m_inertial(inertial)
+    {}
+
+private:
+    /**
+     * Task thread
+     */
+    void run_task() noexcept override;
+
+    /**
+     * Read both sensors and publish their values
+     */
+    void read_sensors() noexcept;
+
+private:
+    emblib::task_stack_t<TASK_IMU_STACK_SIZE> m_task_stack;
+    imu& m_imu;
+    inertial_channel& m_inertial;
+};
+
+}
@@ -1,38 +1,85 @@
 #include "task_logger.hpp"
-#include <cstring>
 
 namespace mp {
 
-ssize_t task_logger::write(const char* data, size_t size, milliseconds_t timeout) noexcept
+// Number of task periods between the reports of dropped messages
+static constexpr uint32_t DROP_REPORT_PERIODS = TASK_LOGGER_DROP_REPORT_PERIOD / TASK_LOGGER_PERIOD;
+
+task_logger::task_logger(emblib::char_dev& log_device, emblib::char_dev& binary_log_device) :
+    task("Task logger", TASK_LOGGER_PRIORITY, m_task_stack),
+    m_log_device(log_device),
+    m_binary_log_device(binary_log_device),
+    m_ring(m_ring_buffer, TASK_LOGGER_RING_SIZE),
+    m_write_busy(false)
+{}
+
+void task_logger::write_device(emblib::char_dev& device, const char* data, size_t size) noexcept
 {
-    UNUSED(timeout);
-    log_msg_s msg;
-    msg.length = size;
-    memcpy(msg.data, data, size);
-    return m_log_msg_queue.send(msg) ? size : -1;
+    if (!device.is_async_available()) {
+        device.write(data, size, milliseconds_t(0));
+        return;
+    }
+
+    m_write_busy.store(true);
+    bool start_status = device.write_async(data, size, [this](ssize_t status) {
+        m_write_busy.store(false);
+        notify_from_isr();
+    });
+    if (!start_status) {
+        m_write_busy.store(false);
+        return;
+    }
+
+    while (m_write_busy.load()) {
+        wait_notification();
+    }
 }
 
-void task_logger::run() noexcept
+void task_logger::report_dropped() noexcept
+{
+    const uint32_t dropped_debug = m_ring.take_dropped(log_level_e::DEBUG);
+    const uint32_t dropped_info = m_ring.take_dropped(log_level_e::INFO);
+    const uint32_t dropped_warning = m_ring.take_dropped(log_level_e::WARNING);
+    const uint32_t dropped_error = m_ring.take_dropped(log_level_e::ERROR);
+
+    if (dropped_debug + dropped_info + dropped_warning + dropped_error > 0) {
+        log_warning(
+            "Dropped logs (debug/info/warning/error): ",
+            dropped_debug, "/", dropped_info, "/", dropped_warning, "/", dropped_error
+        );
+    }
+}
+
+void task_logger::report_suppressed() noexcept
+{
+    log_throttle::flush_idle(get_time_ms(), [](log_level_e level, const char* message, uint32_t suppressed) {
+        logger::get_instance().log(level, "Suppressed ", suppressed, " repeats of: ", message);
+    });
+}
+
+void task_logger::run_task() noexcept
 {
     assert(m_log_device.probe(milliseconds_t(0)));
-    bool use_async = m_log_device.is_async_available();
 
-    log_msg_s recv_msg;
+    uint32_t periods = 0;
     while (true) {
-        // TODO: Bypass this copying by reading the queue's top element data
-        // and removing the item from queue after write somehow
-        m_log_msg_queue.receive(recv_msg);
-
-        if (use_async) {
-            m_log_device.write_async(recv_msg.data, recv_msg.length, [this](ssize_t status) {
-                notify_from_isr();
-            });
-            // TODO: FIX: Only wait for notification if write_async started correctly (returned true)
-            wait_notification();
-        } else {
-            m_log_device.write(recv_msg.data, recv_msg.length, milliseconds_t(0));
+        // Records stay in the ring until they are sent, so
+        // the devices read them directly from the ring
+        mpsc_ring::record_s record;
+        while (m_ring.peek(record)) {
+            emblib::char_dev& device = record.tag == LOG_RECORD_BINARY ? m_binary_log_device : m_log_device;
+            write_device(device, record.data, record.size);
+            m_ring.pop();
         }
+
+        if (++periods == DROP_REPORT_PERIODS) {
+            report_dropped();
+            report_suppressed();
+            periods = 0;
+        }
+
+        sleep_periodic(TASK_LOGGER_PERIOD);
     }
 }
 
-}
\ No newline at end of file
+}
@@ -1,54 +1,75 @@
 #pragma once
 
+#include "task.hpp"
 #include "task_config.hpp"
 #include "util/logger.hpp"
+#include "util/log_ring.hpp"
 #include <emblib/driver/char_dev.hpp>
-#include <emblib/rtos/task.hpp>
-#include <emblib/rtos/queue.hpp>
+#include <atomic>
 
 namespace mp {
 
-class task_logger : public emblib::task, public emblib::char_dev {
+/**
+ * Task which sends the messages from the log ring to the log devices
+ *
+ * Loggers format the messages straight into the ring, and the messages
+ * are sent from the ring without copying. The ring is polled periodically
+ * so that writers never have to notify the task, which keeps writing
+ * safe from ISRs. Messages dropped because the ring was full are counted
+ * per level and reported periodically, together with the repeats of
+ * throttled messages which weren't followed by another occurrence.
+ */
+class task_logger : public task {
 
 public:
     using milliseconds_t = emblib::milliseconds;
 
-    explicit task_logger(emblib::char_dev& log_device) :
-        task("Task logger", TASK_LOGGER_PRIORITY, m_task_stack),
-        m_log_device(log_device)
-    {}
-
     /**
-     * Char dev write interface override
+     * @param binary_log_device Device to which the binary log records are
+     * sent, can be the same as the text log device if it's not shared
      */
-    ssize_t write(const char* data, size_t size, milliseconds_t timeout = milliseconds_t(0)) noexcept override;
+    explicit task_logger(emblib::char_dev& log_device, emblib::char_dev& binary_log_device);
 
     /**
-     * Reading not supported for the log task
+     * Get the ring into which the loggers write the messages
      */
-    ssize_t read(char* buffer, size_t size, milliseconds_t timeout = milliseconds_t(0)) noexcept override
+    log_ring& get_ring() noexcept
     {
-        UNUSED(buffer);
-        UNUSED(size);
-        return -1;
+        return m_ring;
     }
 
 private:
     /**
      * Task thread
      */
-    void run() noexcept override;
+    void run_task() noexcept override;
 
-private:
-    struct log_msg_s {
-        char data[LOGGER_MAX_TOTAL_SIZE];
-        size_t length;
-    };
+    /**
+     * Write the data to the device, waiting for the write to complete
+     */
+    void write_device(emblib::char_dev& device, const char* data, size_t size) noexcept;
+
+    /**
+     * Log the number of dropped messages per level if any were dropped
+     */
+    void report_dropped() noexcept;
+
+    /**
+     * Log the last suppressed counts of the throttled
+     * messages which stopped repeating
+     */
+    void report_suppressed() noexcept;
 
-    emblib::queue<log_msg_s, TASK_LOGGER_QUEUE_SIZE> m_log_msg_queue;
+private:
     emblib::task_stack_t<TASK_LOGGER_STACK_SIZE> m_task_stack;
     emblib::char_dev& m_log_device;
+    emblib::char_dev& m_binary_log_device;
+
+    alignas(4) char m_ring_buffer[TASK_LOGGER_RING_SIZE];
+    log_ring m_ring;
 
+    // Is an async write to one of the devices in progress
+    std::atomic<bool> m_write_busy;
 };
 
-}
\ No newline at end of file
+}
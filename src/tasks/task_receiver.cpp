@@ -1,114 +1,207 @@
 #include "task_receiver.hpp"
+#include "util/crc.hpp"
 #include "util/logger.hpp"
+#include "util/time.hpp"
 #include <pb_decode.h>
+#include <cstring>
 
 namespace mp {
 
+static constexpr uint32_t RING_MASK = TASK_RECEIVER_RING_SIZE - 1;
+static_assert((TASK_RECEIVER_RING_SIZE & RING_MASK) == 0, "Receiver ring size must be a power of 2");
+
+// COBS frame delimiter
+static constexpr uint8_t FRAME_DELIMITER = 0;
+
 task_receiver::task_receiver(emblib::char_dev& receiver_device) noexcept :
     task("Task Receiver", TASK_RECEIVER_PRIORITY, m_task_stack),
-    m_receiver_device(receiver_device)
-{
-    m_pb_istream.callback = &task_receiver::pb_istream_cb;
-    m_pb_istream.state = this;
-    m_pb_istream.bytes_left = SIZE_MAX;
-}
-
-bool task_receiver::get_command(mp_pb_Command& command_buffer) noexcept
+    m_receiver_device(receiver_device),
+    m_read_callback([this](ssize_t status) { complete_read(status); }),
+    m_listener(nullptr),
+    m_head(0),
+    m_tail(0),
+    m_read_active(false),
+    m_scan(0),
+    m_discarding(false)
+{}
+
+bool task_receiver::get_command(received_command_s& command_buffer) noexcept
 {
     // Try to read from queue with timeout 0
     // If the queue is empty it will return false
     return m_command_queue.receive(command_buffer, emblib::ticks_t(0));
 }
 
-bool task_receiver::pb_istream_cb(pb_istream_t *stream, uint8_t *buf, size_t count)
+bool task_receiver::start_read() noexcept
 {
-    // If `buf` is NULL, then the next `count` bytes are not needed
-    // This is static since it doesn't have to be thread-safe as this
-    // data is never used, and the size is chosen to be not to small
-    // to increase overhead, and not too big to waste memory
-    static char discard_buffer[64];
-
-    // This callback is always called from the context of the task
-    task_receiver* this_task = (task_receiver*)stream->state;
-
-    // Callback used when task's receiver finishes
-    ssize_t recv_status = -1;
-    auto read_async_cb = [this_task, &recv_status](ssize_t status) {
-        recv_status = status;
-        this_task->notify_from_isr();
-    };
-
-    if (buf == NULL) {
-        while (count > 0) {
-            size_t to_recv = count > sizeof(discard_buffer) ? sizeof(discard_buffer) : count;
-            
-            // If failed starting the read op, exit
-            if (!this_task->m_receiver_device.read_async(discard_buffer, to_recv, read_async_cb))
-                return false;
-            // This is okay since we know we are in the context of this task
-            this_task->wait_notification();
-
-            if (recv_status <= 0)
-                return false;
-            else
-                count -= recv_status;
-        }
+    if (m_read_active.exchange(true))
         return true;
-    }
 
-    // Try to start an async read and wait for it to finish
-    if (!this_task->m_receiver_device.read_async((char*)buf, count, read_async_cb))
+    // Read into the contiguous free space after the head
+    const uint32_t head = m_head.load(std::memory_order_relaxed);
+    const uint32_t free = TASK_RECEIVER_RING_SIZE - (head - m_tail.load(std::memory_order_acquire));
+    const uint32_t contiguous = TASK_RECEIVER_RING_SIZE - (head & RING_MASK);
+
+    size_t size = free < contiguous ? free : contiguous;
+    size = size < TASK_RECEIVER_READ_CHUNK ? size : TASK_RECEIVER_READ_CHUNK;
+
+    if (size == 0 || !m_receiver_device.read_async((char*)&m_ring[head & RING_MASK], size, m_read_callback)) {
+        m_read_active.store(false);
         return false;
+    }
+    return true;
+}
+
+void task_receiver::complete_read(ssize_t status) noexcept
+{
+    bool wake_task = false;
+
+    if (status > 0) {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        // Only wake the task once there is a whole frame to decode
+        wake_task = memchr(&m_ring[head & RING_MASK], FRAME_DELIMITER, status) != nullptr;
+        m_head.store(head + status, std::memory_order_release);
+    } else {
+        wake_task = true;
+    }
 
-    this_task->wait_notification();
-    return recv_status == count;
+    // Keep receiving without waiting for the task, which
+    // restarts the reading if this fails or the ring is full
+    m_read_active.store(false);
+    if (!start_read())
+        wake_task = true;
+
+    if (wake_task)
+        notify_from_isr();
 }
 
-void task_receiver::run() noexcept
+void task_receiver::process_received() noexcept
 {
-    assert(m_receiver_device.is_async_available());
+    const uint32_t head = m_head.load(std::memory_order_acquire);
+
+    while (m_scan != head) {
+        const uint8_t byte = m_ring[m_scan & RING_MASK];
+        m_scan++;
+
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if (byte != FRAME_DELIMITER) {
+            // Frame can't be this large, so something was lost, drop
+            // everything until the next delimiter to free up the ring
+            if (m_scan - tail > MAX_ENCODED_FRAME_SIZE) {
+                m_discarding = true;
+                m_tail.store(m_scan, std::memory_order_release);
+            }
+            continue;
+        }
 
-    while (true) {
-        mp_pb_Command recv_command = mp_pb_Command_init_zero;
+        if (!m_discarding) {
+            handle_frame(tail, m_scan - 1 - tail);
+        }
+        m_discarding = false;
+        m_tail.store(m_scan, std::memory_order_release);
+    }
+}
+
+void task_receiver::handle_frame(uint32_t start, size_t size) noexcept
+{
+    // Empty frames are allowed, they can be used to flush the line
+    if (size == 0)
+        return;
+
+    // Frames are decoded in place, except the ones
+    // which wrap around and have to be copied first
+    uint8_t* frame = &m_ring[start & RING_MASK];
+    const size_t first_part = TASK_RECEIVER_RING_SIZE - (start & RING_MASK);
+    if (size > first_part) {
+        memcpy(m_frame_buffer, frame, first_part);
+        memcpy(m_frame_buffer + first_part, m_ring, size - first_part);
+        frame = m_frame_buffer;
+    }
+
+    const ssize_t decoded_size = cobs_decode(frame, size, frame);
+    // Type and CRC at least
+    if (decoded_size < 3) {
+        MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_RECEIVER, std::chrono::seconds(1), "Receiver invalid frame!");
+        return;
+    }
 
-#if TASK_RECEIVER_STREAM_DATA
-        if (pb_decode(&m_pb_istream, mp_pb_Command_fields, &recv_command)) {
-            // Send to queue with infinite timeout
-            m_command_queue.send(recv_command);
+    const size_t data_size = decoded_size - 2;
+    const uint16_t frame_crc = frame[data_size] | (frame[data_size + 1] << 8);
+    if (crc16_ccitt(frame, data_size) != frame_crc) {
+        MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_RECEIVER, std::chrono::seconds(1), "Receiver frame CRC mismatch!");
+        return;
+    }
+
+    const uint8_t* payload = frame + 1;
+    const size_t payload_size = data_size - 1;
+
+    switch (frame[0]) {
+    case mp_pb_ReceiverFrameType_RECEIVER_FRAME_TYPE_COMMAND: {
+        received_command_s received = {mp_pb_Command_init_zero, get_time_us()};
+        pb_istream_t istream = pb_istream_from_buffer(payload, payload_size);
+        if (pb_decode(&istream, mp_pb_Command_fields, &received.command)) {
+            m_command_queue.send(received);
+            notify_listener();
         } else {
-            log_error("Receiver decoding failed!");
-            // Decode process (probably reading) was not successful, go
-            // to sleep for some time
-            sleep(std::chrono::milliseconds(100));
+            MP_LOGS_ERROR(mp_pb_Subsystem_SUBSYSTEM_RECEIVER, "Receiver decoding failed!");
         }
-#else
-        char recv_buf[sizeof(mp_pb_Command)];
-
-        ssize_t recv_status = -1;
-        bool start_status = m_receiver_device.read_async(recv_buf, sizeof(recv_buf), [this, &recv_status](ssize_t status){
-            recv_status = status;
-            notify_from_isr();
-        });
-        
-        if (!start_status) {
-            log_warning("Receiver read start fail!");
-            // Sleep to give time to the receiver to unblock
+        break;
+    }
+    case mp_pb_ReceiverFrameType_RECEIVER_FRAME_TYPE_RC:
+        handle_rc_frame(payload, payload_size);
+        break;
+    default:
+        MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_RECEIVER, std::chrono::seconds(1), "Receiver unknown frame type: ", frame[0]);
+        break;
+    }
+}
+
+void task_receiver::handle_rc_frame(const uint8_t* payload, size_t size) noexcept
+{
+    static constexpr size_t RC_FRAME_SIZE = 2 + 2 * RC_CHANNEL_COUNT;
+    static constexpr float RC_CHANNEL_SCALE = 1.f / 32767.f;
+
+    if (size != RC_FRAME_SIZE) {
+        MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_RECEIVER, std::chrono::seconds(1), "Receiver invalid RC frame size: ", size);
+        return;
+    }
+
+    rc_input_s input;
+    input.sequence = payload[0] | (payload[1] << 8);
+    for (size_t i = 0; i < RC_CHANNEL_COUNT; i++) {
+        const int16_t raw = static_cast<int16_t>(payload[2 + 2 * i] | (payload[3 + 2 * i] << 8));
+        // -32768 is clamped so that the range is symmetric
+        input.channels[i] = raw < -32767 ? -1.f : raw * RC_CHANNEL_SCALE;
+    }
+    m_rc_input.write(input);
+    notify_listener();
+}
+
+void task_receiver::notify_listener() noexcept
+{
+    emblib::task* listener = m_listener.load();
+    if (listener)
+        listener->notify();
+}
+
+void task_receiver::run_task() noexcept
+{
+    assert(m_receiver_device.is_async_available());
+
+    while (true) {
+        // Reading is normally restarted from the read callback, unless it
+        // failed there, so if it fails here too give the receiver time to unblock
+        if (!start_read()) {
+            MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_RECEIVER, std::chrono::seconds(1), "Receiver read start fail!");
             sleep(std::chrono::milliseconds(100));
             continue;
         }
 
         wait_notification();
-        if (recv_status <= 0) {
-            log_error("Receiver read error!");
-            continue;
-        }
-
-        pb_istream_t buf_istream = pb_istream_from_buffer((const pb_byte_t*)recv_buf, recv_status);
-        if (pb_decode(&buf_istream, mp_pb_Command_fields, &recv_command)) {
-            m_command_queue.send(recv_command);
-        }
+        begin_iteration(get_time_us());
+        process_received();
+        end_iteration(0);
     }
-#endif
 }
 
-}
\ No newline at end of file
+}
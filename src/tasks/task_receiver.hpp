@@ -1,15 +1,49 @@
 #pragma once
 
+#include "task.hpp"
 #include "task_config.hpp"
+#include "util/cobs.hpp"
+#include "util/seqlock.hpp"
+#include "vehicles/vehicle.hpp"
 #include "pb/command.pb.h"
+#include "pb/frame.pb.h"
 #include <emblib/driver/char_dev.hpp>
-#include <emblib/rtos/task.hpp>
 #include <emblib/rtos/queue.hpp>
-#include <pb_decode.h>
+#include <atomic>
 
 namespace mp {
 
-class task_receiver : public emblib::task {
+/**
+ * Decoded command along with the time it was received
+ */
+struct received_command_s {
+    mp_pb_Command command;
+    uint64_t receive_time_us;
+};
+
+/**
+ * Task which receives and decodes the commands
+ *
+ * Data is received continuously into a ring buffer, with the next read
+ * started from the completion callback of the previous one, so reception
+ * never waits for the task. The received stream consists of COBS encoded
+ * frames delimited with zero bytes (see frame.proto). The task is only woken
+ * up once a delimiter is received, and decodes the frame in place in the ring.
+ * Corrupted frames fail the CRC check and are dropped, and decoding resumes
+ * from the next delimiter. Stick input frames have a fixed layout and are
+ * published as the latest value instead of being queued.
+ *
+ * @note The receiver device should complete a read early when the line
+ * goes idle (like UART DMA with idle detection), otherwise the last frame
+ * is delayed until `TASK_RECEIVER_READ_CHUNK` bytes are received.
+ */
+class task_receiver : public task {
+
+    // Type + largest payload + CRC
+    static constexpr size_t MAX_FRAME_SIZE = 1 + mp_pb_Command_size + 2;
+    static constexpr size_t MAX_ENCODED_FRAME_SIZE = cobs_max_encoded_size(MAX_FRAME_SIZE);
+    static_assert(MAX_ENCODED_FRAME_SIZE < TASK_RECEIVER_RING_SIZE, "Ring must fit a whole frame");
+
 public:
     task_receiver(emblib::char_dev& receiver_device) noexcept;
 
@@ -17,28 +51,89 @@ public:
      * Returns true if a command was available and was successfully copied
      * into the provided buffer
      */
-    bool get_command(mp_pb_Command& command_buffer) noexcept;
+    bool get_command(received_command_s& command_buffer) noexcept;
+
+    /**
+     * Copy the latest stick input
+     * @returns false if no input was received yet
+     * @note Input is kept until overwritten, compare the sequence
+     * number to find out if it's new
+     */
+    bool get_rc_input(rc_input_s& input) const noexcept
+    {
+        return m_rc_input.read(input);
+    }
+
+    /**
+     * Set the task which is notified whenever a command
+     * or stick input is received, `nullptr` to disable
+     */
+    void set_listener(emblib::task* listener) noexcept
+    {
+        m_listener.store(listener);
+    }
 
 private:
     /**
-     * Callback for receiving data as it is needed (we do not
-     * receive a full buffer of data ahead of starting the decoding)
-     * 
-     * This is called during the execution of nanopb's pb_decode function
+     * Start the next read into the free part of the ring if one is not already in progress
+     * @returns false if the read didn't start, either because the ring is full or the
+     * device failed to start it
+     * @note Called from the task and from the read callback
+     */
+    bool start_read() noexcept;
+
+    /**
+     * Called from the device once a read is completed
      */
-    static bool pb_istream_cb(pb_istream_t *stream, uint8_t *buf, size_t count);
+    void complete_read(ssize_t status) noexcept;
+
+    /**
+     * Find and handle all the frames received so far
+     */
+    void process_received() noexcept;
+
+    /**
+     * Decode the COBS encoded frame which starts at the
+     * given ring position, and dispatch it by its type
+     */
+    void handle_frame(uint32_t start, size_t size) noexcept;
+
+    /**
+     * Decode the fixed layout stick input frame and publish it
+     */
+    void handle_rc_frame(const uint8_t* payload, size_t size) noexcept;
+
+    /**
+     * Wake up the listener, if any, to handle the received input
+     */
+    void notify_listener() noexcept;
 
     /**
      * Implementation of the task
      */
-    void run() noexcept override;
+    void run_task() noexcept override;
 
 private:
     emblib::task_stack_t<TASK_RECEIVER_STACK_SIZE> m_task_stack;
-    emblib::queue<mp_pb_Command, TASK_RECEIVER_QUEUE_SIZE> m_command_queue;
+    emblib::queue<received_command_s, TASK_RECEIVER_QUEUE_SIZE> m_command_queue;
+    // Stick input bypasses the queue, only the latest one matters
+    seqlock<rc_input_s> m_rc_input;
     emblib::char_dev& m_receiver_device;
+    emblib::char_dev::callback_t m_read_callback;
+    std::atomic<emblib::task*> m_listener;
+
+    uint8_t m_ring[TASK_RECEIVER_RING_SIZE];
+    // Free running positions, written by the read callback and the task
+    std::atomic<uint32_t> m_head;
+    std::atomic<uint32_t> m_tail;
+    std::atomic<bool> m_read_active;
+    // Position up to which the task looked for the delimiters
+    uint32_t m_scan;
+    // Set while skipping a frame which is too large, until the next delimiter
+    bool m_discarding;
 
-    pb_istream_t m_pb_istream;
+    // Used for the frames which wrap around the end of the ring
+    uint8_t m_frame_buffer[MAX_ENCODED_FRAME_SIZE];
 };
 
-}
\ No newline at end of file
+}
@@ -8,16 +8,17 @@ namespace mp {
 // Conversion of the task period to floating point delta time
 inline constexpr float DT = std::chrono::duration<float>(TASK_STATE_PERIOD).count();
 
-void task_state_estimator::run() noexcept
+void task_state_estimator::run_task() noexcept
 {
     // Assuming that sensor covariances won't change during runtime
-    const matrix3f accel_cov = m_task_accel.get_noise_variance();
-    const matrix3f gyro_cov = m_task_gyro.get_noise_variance();
+    const matrix3f accel_cov = m_inertial.get_accelerometer().get_noise_variance();
+    const matrix3f gyro_cov = m_inertial.get_gyroscope().get_noise_variance();
     
     while (true) {
-        // Get latest sensor measurements
-        vector3f a_read = m_task_accel.get_corrected();
-        vector3f w_read = m_task_gyro.get_corrected();
+        // Get latest sensor measurements, of the same read with the IMU
+        const inertial_channel::sample_s sample = m_inertial.get_corrected_sample();
+        vector3f a_read = sample.acceleration;
+        vector3f w_read = sample.angular_velocity;
         // TODO: Get rest of the sensors here
         
         sensor_data_s sensor_data {
@@ -31,6 +32,11 @@ void task_state_estimator::run() noexcept
         // Assign the estimator state to the readable state struct
         m_state_mutex.lock();
         m_state = m_state_estimator.get_state();
+        m_state.timestamp_us = sample.timestamp_us;
+        m_angular_velocity_stats.add(m_state.angular_velocity);
+        m_motion_stats.position.add(m_state.position);
+        m_motion_stats.velocity.add(m_state.velocity);
+        m_motion_stats.acceleration.add(m_state.acceleration);
         m_state_mutex.unlock();
 
         sleep_periodic(TASK_STATE_PERIOD);
@@ -1,30 +1,38 @@
 #pragma once
 
+#include "task.hpp"
 #include "task_config.hpp"
 #include "state/state_estimator.hpp"
-#include "tasks/task_accelerometer.hpp"
-#include "tasks/task_gyroscope.hpp"
+#include "sensors/inertial_channel.hpp"
+#include "util/running_stats.hpp"
 #include <emblib/rtos/mutex.hpp>
-#include <emblib/rtos/task.hpp>
 
 namespace mp {
 
 /**
  * Task responsible for getting the sensor data and estimating the model state
  */
-class task_state_estimator : public emblib::task {
+class task_state_estimator : public task {
+
+public:
+    /**
+     * Statistics of the state fields sent in the motion telemetry stream
+     */
+    struct motion_stats_s {
+        running_stats3f position;
+        running_stats3f velocity;
+        running_stats3f acceleration;
+    };
 
 public:
     // TODO: Add an initial state parameter
     explicit task_state_estimator(
         state_estimator& state_estimator,
-        task_accelerometer& task_accel,
-        task_gyroscope& task_gyro
+        inertial_channel& inertial
     ) noexcept :
         task("Task state estimator", TASK_STATE_PRIORITY, m_task_stack),
         m_state_estimator(state_estimator),
-        m_task_accel(task_accel),
-        m_task_gyro(task_gyro)
+        m_inertial(inertial)
     {}
 
     /**
@@ -37,11 +45,31 @@ public:
         return m_state;
     }
 
+    /**
+     * Get the statistics of the angular velocity since the previous call
+     */
+    running_stats3f take_angular_velocity_stats() noexcept
+    {
+        emblib::scoped_lock lock(m_state_mutex);
+        return m_angular_velocity_stats.take();
+    }
+
+    /**
+     * Get the statistics of the motion state fields since the previous call
+     */
+    motion_stats_s take_motion_stats() noexcept
+    {
+        emblib::scoped_lock lock(m_state_mutex);
+        motion_stats_s stats = m_motion_stats;
+        m_motion_stats = motion_stats_s();
+        return stats;
+    }
+
 private:
     /**
      * Task thread
      */
-    void run() noexcept override;
+    void run_task() noexcept override;
 
 private:
     emblib::task_stack_t<TASK_STATE_STACK_SIZE> m_task_stack;
@@ -49,9 +77,12 @@ private:
     state_s m_state;
     state_estimator& m_state_estimator;
     emblib::mutex m_state_mutex;
+    // Updated together with the state, taken separately
+    // since the streams can be sent at different rates
+    running_stats3f m_angular_velocity_stats;
+    motion_stats_s m_motion_stats;
     
-    task_accelerometer& m_task_accel;
-    task_gyroscope& m_task_gyro;
+    inertial_channel& m_inertial;
 };
 
 }
\ No newline at end of file
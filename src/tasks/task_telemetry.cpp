@@ -1,80 +1,416 @@
 #include "task_telemetry.hpp"
 #include "util/pb_util.hpp"
+#include "util/trace.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace mp {
 
+// Telemetry tick period in microseconds used for compact frame timestamps
+static constexpr uint32_t TICK_PERIOD_US = std::chrono::microseconds(TASK_TELEMETRY_PERIOD).count();
+// Maximum time the first sample of a compact batch can wait to be sent, in ticks
+static constexpr uint32_t COMPACT_MAX_LATENCY_TICKS = TASK_TELEMETRY_COMPACT_MAX_LATENCY / TASK_TELEMETRY_PERIOD;
+
 task_telemetry::task_telemetry(
     emblib::char_dev& telemetry_device,
-    task_accelerometer& task_accelerometer,
-    task_gyroscope& task_gyroscope,
-    task_state_estimator& task_state_estimator
+    emblib::char_dev& compact_device,
+    accelerometer_channel& accelerometer,
+    gyroscope_channel& gyroscope,
+    task_state_estimator& task_state_estimator,
+    vehicle& vehicle
 ) :
     task("Task telemetry", TASK_TELEMETRY_PRIORITY, m_task_stack),
     m_telemetry_device(telemetry_device),
-    m_task_accel(task_accelerometer),
-    m_task_gyro(task_gyroscope),
-    m_task_state(task_state_estimator)
-{}
+    m_scheduler(TASK_TELEMETRY_PERIOD, TASK_TELEMETRY_DEFAULT_RATE),
+    m_tx_index(0),
+    m_tx_busy(false),
+    m_stats_reset_pending(0),
+    m_task_timing_count(0),
+    m_latency {},
+    m_unsent_windows(0),
+    m_compact_device(compact_device),
+    m_compact_index(0),
+    m_compact_busy(false),
+    m_accelerometer(accelerometer),
+    m_gyroscope(gyroscope),
+    m_task_state(task_state_estimator),
+    m_vehicle(vehicle)
+{
+    for (size_t stream = 0; stream < telemetry_scheduler::STREAM_COUNT; stream++) {
+        m_compact_batches[stream].set_stream(static_cast<telemetry_stream_e>(stream));
+    }
+}
 
-void task_telemetry::run() noexcept
+void task_telemetry::collect_stream_stats(telemetry_stream_e stream) noexcept
 {
-    // This doesn't have to be an assert
-    // Can just exit and turn off the telemetry task
-    assert(m_telemetry_device.probe(emblib::milliseconds(0)));
+    running_stats3f* stats = m_stream_stats[stream];
 
-    while (true) {
-        mp_pb_TelemetryMessage msg = mp_pb_TelemetryMessage_init_zero;
+    switch (stream) {
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_ATTITUDE:
+        stats[0].merge(m_task_state.take_angular_velocity_stats());
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_MOTION: {
+        const task_state_estimator::motion_stats_s motion_stats = m_task_state.take_motion_stats();
+        stats[0].merge(motion_stats.position);
+        stats[1].merge(motion_stats.velocity);
+        stats[2].merge(motion_stats.acceleration);
+        break;
+    }
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_SENSOR_RAW:
+        stats[0].merge(m_accelerometer.take_raw_stats());
+        stats[1].merge(m_gyroscope.take_raw_stats());
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_SENSOR_CORRECTED:
+        stats[0].merge(m_accelerometer.take_corrected_stats());
+        stats[1].merge(m_gyroscope.take_corrected_stats());
+        break;
+    default:
+        break;
+    }
+}
+
+void task_telemetry::take_stream_window(telemetry_stream_e stream) noexcept
+{
+    switch (stream) {
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_TASKS:
+        m_task_timing_count = std::min(task::get_task_count(), MAX_TASK_TIMINGS);
+        for (size_t i = 0; i < m_task_timing_count; i++)
+            m_task_timings[i] = task::get_task(i).take_timing();
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_LATENCY:
+        m_latency = m_vehicle.take_actuation_latency();
+        break;
+    default:
+        return;
+    }
+    m_unsent_windows |= 1u << stream;
+}
+
+void task_telemetry::reset_subscribed_stats() noexcept
+{
+    const uint32_t pending = m_stats_reset_pending.exchange(0);
+    for (size_t stream = 0; stream < telemetry_scheduler::STREAM_COUNT; stream++) {
+        if (!(pending & (1u << stream)))
+            continue;
+
+        collect_stream_stats(static_cast<telemetry_stream_e>(stream));
+        for (running_stats3f& stats : m_stream_stats[stream])
+            stats.reset();
+
+        take_stream_window(static_cast<telemetry_stream_e>(stream));
+        m_unsent_windows &= ~(1u << stream);
+    }
+}
+
+void task_telemetry::set_stream_fields(mp_pb_TelemetryMessage& msg, telemetry_stream_e stream) noexcept
+{
+    // Statistics are always collected so that they
+    // cover only the interval since the last message
+    collect_stream_stats(stream);
+    const running_stats3f* stats = m_stream_stats[stream];
+    const bool with_stats = m_scheduler.has_statistics(stream);
+
+    switch (stream) {
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_ATTITUDE: {
+        const state_s state = m_task_state.get_state();
+        pb_vector4f_set(msg.state.rotation, state.rotationq.as_vector());
+        pb_vector3f_set(msg.state.angular_velocity, state.angular_velocity);
+        msg.state.has_rotation = true;
+        msg.state.has_angular_velocity = true;
+        msg.has_state = true;
 
-        // State data
-        state_s state = m_task_state.get_state();
+        if (with_stats) {
+            pb_vector3f_stats_set(msg.state.angular_velocity_stats, stats[0]);
+            msg.state.has_angular_velocity_stats = true;
+        }
+        break;
+    }
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_MOTION: {
+        const state_s state = m_task_state.get_state();
         pb_vector3f_set(msg.state.position, state.position);
         pb_vector3f_set(msg.state.velocity, state.velocity);
         pb_vector3f_set(msg.state.acceleration, state.acceleration);
-        pb_vector3f_set(msg.state.angular_velocity, state.angular_velocity);
-        pb_vector4f_set(msg.state.rotation, state.rotationq.as_vector());
         msg.state.has_position = true;
         msg.state.has_velocity = true;
         msg.state.has_acceleration = true;
-        msg.state.has_angular_velocity = true;
-        msg.state.has_rotation = true;
         msg.has_state = true;
-        
-        // Sensor data
-        pb_vector3f_set(msg.sensor_data.acc_raw, m_task_accel.get_raw());
-        pb_vector3f_set(msg.sensor_data.acc_corrected, m_task_accel.get_corrected());
-        pb_vector3f_set(msg.sensor_data.gyro_raw, m_task_gyro.get_raw());
-        pb_vector3f_set(msg.sensor_data.gyro_corrected, m_task_gyro.get_corrected());
+
+        if (with_stats) {
+            pb_vector3f_stats_set(msg.state.position_stats, stats[0]);
+            pb_vector3f_stats_set(msg.state.velocity_stats, stats[1]);
+            pb_vector3f_stats_set(msg.state.acceleration_stats, stats[2]);
+            msg.state.has_position_stats = true;
+            msg.state.has_velocity_stats = true;
+            msg.state.has_acceleration_stats = true;
+        }
+        break;
+    }
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_SENSOR_RAW:
+        pb_vector3f_set(msg.sensor_data.acc_raw, m_accelerometer.get_raw());
+        pb_vector3f_set(msg.sensor_data.gyro_raw, m_gyroscope.get_raw());
         msg.sensor_data.has_acc_raw = true;
-        msg.sensor_data.has_acc_corrected = true;
         msg.sensor_data.has_gyro_raw = true;
+        msg.has_sensor_data = true;
+
+        if (with_stats) {
+            pb_vector3f_stats_set(msg.sensor_data.acc_raw_stats, stats[0]);
+            pb_vector3f_stats_set(msg.sensor_data.gyro_raw_stats, stats[1]);
+            msg.sensor_data.has_acc_raw_stats = true;
+            msg.sensor_data.has_gyro_raw_stats = true;
+        }
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_SENSOR_CORRECTED:
+        pb_vector3f_set(msg.sensor_data.acc_corrected, m_accelerometer.get_corrected());
+        pb_vector3f_set(msg.sensor_data.gyro_corrected, m_gyroscope.get_corrected());
+        msg.sensor_data.has_acc_corrected = true;
         msg.sensor_data.has_gyro_corrected = true;
         msg.has_sensor_data = true;
 
-        // TODO: Send vehicle specific telemetry here
+        if (with_stats) {
+            pb_vector3f_stats_set(msg.sensor_data.acc_corrected_stats, stats[0]);
+            pb_vector3f_stats_set(msg.sensor_data.gyro_corrected_stats, stats[1]);
+            msg.sensor_data.has_acc_corrected_stats = true;
+            msg.sensor_data.has_gyro_corrected_stats = true;
+        }
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_TASKS: {
+        // Timings of a window which wasn't sent are sent instead of taking
+        // new ones, the tasks gather the next window in the meantime
+        if (!(m_unsent_windows & (1u << stream)))
+            take_stream_window(stream);
+        for (size_t i = 0; i < m_task_timing_count; i++) {
+            const task_timing_s& timing = m_task_timings[i];
+            mp_pb_TelemetryTaskTiming& pb_timing = msg.tasks[i];
+            strncpy(pb_timing.name, task::get_task(i).get_name(), sizeof(pb_timing.name) - 1);
+            pb_timing.iterations = timing.iterations;
+            pb_timing.deadline_misses = timing.deadline_misses;
+            pb_timing.period_us = timing.period_us;
+            pb_timing.exec_mean_us = timing.exec_mean_us;
+            pb_timing.exec_max_us = timing.exec_max_us;
+            pb_timing.jitter_max_us = timing.jitter_max_us;
+        }
+        msg.tasks_count = m_task_timing_count;
+        break;
+    }
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_LATENCY:
+        // Taking restarts the histogram, so same as the task timings a
+        // summary which wasn't sent is sent instead of taking a new one
+        if (!(m_unsent_windows & (1u << stream)))
+            take_stream_window(stream);
+        msg.latency.count = m_latency.count;
+        msg.latency.p50_us = m_latency.p50_us;
+        msg.latency.p99_us = m_latency.p99_us;
+        msg.latency.max_us = m_latency.max_us;
+        msg.has_latency = true;
+        break;
+    default:
+        break;
+    }
+}
 
-        // Messages are encoded into a buffer before being sent
-        // to avoid message fragmentation since the output device
-        // can be used by other tasks such as the logger
-        char out_buffer[sizeof(mp_pb_TelemetryMessage)];
-        pb_ostream_t pb_ostream = pb_ostream_from_buffer((pb_byte_t*)out_buffer, sizeof(out_buffer));
+void task_telemetry::clear_stream_fields(mp_pb_TelemetryMessage& msg, telemetry_stream_e stream) noexcept
+{
+    switch (stream) {
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_ATTITUDE:
+        msg.state.has_rotation = false;
+        msg.state.has_angular_velocity = false;
+        msg.state.has_angular_velocity_stats = false;
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_MOTION:
+        msg.state.has_position = false;
+        msg.state.has_velocity = false;
+        msg.state.has_acceleration = false;
+        msg.state.has_position_stats = false;
+        msg.state.has_velocity_stats = false;
+        msg.state.has_acceleration_stats = false;
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_SENSOR_RAW:
+        msg.sensor_data.has_acc_raw = false;
+        msg.sensor_data.has_gyro_raw = false;
+        msg.sensor_data.has_acc_raw_stats = false;
+        msg.sensor_data.has_gyro_raw_stats = false;
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_SENSOR_CORRECTED:
+        msg.sensor_data.has_acc_corrected = false;
+        msg.sensor_data.has_gyro_corrected = false;
+        msg.sensor_data.has_acc_corrected_stats = false;
+        msg.sensor_data.has_gyro_corrected_stats = false;
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_TASKS:
+        msg.tasks_count = 0;
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_LATENCY:
+        msg.has_latency = false;
+        break;
+    default:
+        break;
+    }
+    
+    // Remove the parent messages if they're left empty, statistics
+    // are only present together with the fields they belong to
+    msg.has_state = msg.state.has_rotation || msg.state.has_angular_velocity ||
+        msg.state.has_position || msg.state.has_velocity || msg.state.has_acceleration;
+    msg.has_sensor_data = msg.sensor_data.has_acc_raw || msg.sensor_data.has_gyro_raw ||
+        msg.sensor_data.has_acc_corrected || msg.sensor_data.has_gyro_corrected;
+}
+
+void task_telemetry::append_compact_sample(telemetry_stream_e stream) noexcept
+{
+    telemetry_compact_batch& batch = m_compact_batches[stream];
+    const uint32_t period_us = m_scheduler.get_period(stream) * TICK_PERIOD_US;
+
+    // Samples in a batch are equally spaced, so a rate change starts a new batch
+    if (batch.get_count() > 0 && batch.get_period_us() != period_us)
+        send_compact_batch(batch);
+    if (batch.get_count() == 0)
+        batch.start(static_cast<uint64_t>(m_scheduler.get_tick()) * TICK_PERIOD_US, period_us);
+
+    switch (stream) {
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_ATTITUDE:
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_MOTION:
+        batch.append_state(m_task_state.get_state());
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_SENSOR_RAW:
+        batch.append_sensor_data(m_accelerometer.get_raw(), m_gyroscope.get_raw());
+        break;
+    case mp_pb_TelemetryStream_TELEMETRY_STREAM_SENSOR_CORRECTED:
+        batch.append_sensor_data(m_accelerometer.get_corrected(), m_gyroscope.get_corrected());
+        break;
+    default:
+        // Rejected by the scheduler, see `telemetry_scheduler::subscribe`
+        break;
+    }
+}
+
+void task_telemetry::flush_compact_batches() noexcept
+{
+    for (size_t stream = 0; stream < telemetry_scheduler::STREAM_COUNT; stream++) {
+        telemetry_compact_batch& batch = m_compact_batches[stream];
+        if (batch.get_count() == 0)
+            continue;
+
+        const telemetry_stream_e stream_e = static_cast<telemetry_stream_e>(stream);
+        const uint32_t period = m_scheduler.get_period(stream_e);
+        const bool is_compact = m_scheduler.get_encoding(stream_e) == mp_pb_TelemetryEncoding_TELEMETRY_ENCODING_COMPACT;
+
+        if (batch.is_full() || !is_compact || period == 0 || batch.get_count() * period >= COMPACT_MAX_LATENCY_TICKS)
+            send_compact_batch(batch);
+    }
+}
+
+void task_telemetry::send_compact_batch(telemetry_compact_batch& batch) noexcept
+{
+    auto& frame = m_compact_buffers[m_compact_index];
+    const size_t frame_size = batch.encode_frame(frame);
+    transmit(m_compact_device, m_compact_busy, frame, frame_size);
+    m_compact_index ^= 1;
+}
+
+void task_telemetry::transmit(emblib::char_dev& device, std::atomic<bool>& tx_busy, const char* data, size_t size) noexcept
+{
+    if (!device.is_async_available()) {
+        device.write(data, size, std::chrono::milliseconds(0));
+        return;
+    }
+
+    // Previous frame was being sent from the other buffer while this one was
+    // encoded, and the device can only take one transfer at a time. The flag
+    // is checked since the notification could also come from the other device
+    while (tx_busy.load()) {
+        wait_notification();
+    }
+
+    tx_busy.store(true);
+    bool start_status = device.write_async(data, size, [this, &tx_busy](ssize_t status) {
+        tx_busy.store(false);
+        notify_from_isr();
+    });
+
+    // Frame is dropped, e.g. if it's too large for the transmitter channel
+    if (!start_status) {
+        tx_busy.store(false);
+        MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_TELEMETRY, std::chrono::seconds(1), "Telemetry frame not sent");
+    }
+}
+
+void task_telemetry::run_task() noexcept
+{
+    // This doesn't have to be an assert
+    // Can just exit and turn off the telemetry task
+    assert(m_telemetry_device.probe(emblib::milliseconds(0)));
+
+    while (true) {
+        reset_subscribed_stats();
+
+        telemetry_stream_e due_streams[telemetry_scheduler::STREAM_COUNT];
+        const size_t due_count = m_scheduler.get_due(due_streams);
+
+        // Same as `mp_pb_TelemetryMessage_init_zero`, without a temporary on the stack
+        mp_pb_TelemetryMessage& msg = m_msg;
+        memset(&msg, 0, sizeof(msg));
+        size_t streams_packed = 0;
+
+        // Pack the due streams, most overdue first, until the frame budget is
+        // reached. Streams which don't fit stay due for the next tick
+        for (size_t i = 0; i < due_count; i++) {
+            // Compact streams are batched separately and don't count towards the budget
+            if (m_scheduler.get_encoding(due_streams[i]) == mp_pb_TelemetryEncoding_TELEMETRY_ENCODING_COMPACT) {
+                append_compact_sample(due_streams[i]);
+                m_scheduler.mark_sent(due_streams[i]);
+                continue;
+            }
+
+            set_stream_fields(msg, due_streams[i]);
+
+            size_t encoded_size = 0;
+            pb_get_encoded_size(&encoded_size, mp_pb_TelemetryMessage_fields, &msg);
+            // Always send at least one stream so that a stream larger
+            // than the budget doesn't starve forever
+            if (encoded_size > TASK_TELEMETRY_FRAME_BUDGET && streams_packed > 0) {
+                clear_stream_fields(msg, due_streams[i]);
+                continue;
+            }
+            // Stream which doesn't fit into a frame on its own can never be sent
+            if (encoded_size > TELEMETRY_BUFFER_SIZE) {
+                clear_stream_fields(msg, due_streams[i]);
+                m_scheduler.mark_sent(due_streams[i]);
+                m_unsent_windows &= ~(1u << due_streams[i]);
+                MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_TELEMETRY, std::chrono::seconds(1), "Telemetry stream too large for a frame");
+                continue;
+            }
+
+            m_scheduler.mark_sent(due_streams[i]);
+            m_unsent_windows &= ~(1u << due_streams[i]);
+            for (running_stats3f& stats : m_stream_stats[due_streams[i]])
+                stats.reset();
+            streams_packed++;
+        }
+
+        flush_compact_batches();
         
-        if (pb_encode(&pb_ostream, mp_pb_TelemetryMessage_fields, &msg)) {
-            if (m_telemetry_device.is_async_available()) {
-                bool start_status = m_telemetry_device.write_async(out_buffer, pb_ostream.bytes_written, [this](ssize_t status) {
-                    notify_from_isr();
-                });
-
-                if (start_status)
-                    wait_notification();
+        // TODO: Send vehicle specific telemetry here
+
+        if (streams_packed > 0) {
+            // Messages are encoded into a buffer before being sent
+            // to avoid message fragmentation since the output device
+            // can be used by other tasks such as the logger
+            MP_TRACE_SCOPE("telemetry encode");
+            char* out_buffer = m_tx_buffers[m_tx_index];
+            pb_ostream_t pb_ostream = pb_ostream_from_buffer((pb_byte_t*)out_buffer, TELEMETRY_BUFFER_SIZE);
+            
+            if (pb_encode(&pb_ostream, mp_pb_TelemetryMessage_fields, &msg)) {
+                transmit(m_telemetry_device, m_tx_busy, out_buffer, pb_ostream.bytes_written);
+                // Encode the next frame into the other buffer
+                // while this one is being transmitted
+                m_tx_index ^= 1;
             } else {
-                m_telemetry_device.write(out_buffer, pb_ostream.bytes_written, std::chrono::milliseconds(0));
+                MP_LOGS_ERROR(mp_pb_Subsystem_SUBSYSTEM_TELEMETRY, "Failed to encode telemetry!");
             }
-        } else {
-            log_error("Failed to encode telemetry!");
         }
-        
+
+        m_scheduler.advance();
         sleep_periodic(TASK_TELEMETRY_PERIOD);
     }
 }
 
-}
\ No newline at end of file
+}
@@ -1,43 +1,163 @@
 #pragma once
 
+#include "task.hpp"
 #include "task_config.hpp"
-#include "task_accelerometer.hpp"
-#include "task_gyroscope.hpp"
 #include "task_state_estimator.hpp"
+#include "task_transmitter.hpp"
+#include "sensors/accelerometer_channel.hpp"
+#include "sensors/gyroscope_channel.hpp"
+#include "telemetry/telemetry_compact.hpp"
+#include "telemetry/telemetry_scheduler.hpp"
+#include "vehicles/vehicle.hpp"
 #include "pb/telemetry.pb.h"
 #include <emblib/driver/char_dev.hpp>
-#include <emblib/rtos/task.hpp>
 #include <emblib/rtos/queue.hpp>
 #include <pb_encode.h>
+#include <atomic>
+#include <type_traits>
 
 namespace mp {
 
-// Change to task_transmitter and add queue for output messages
-// Also pack each message into protobuf which describes the type
-// Example: LogMessage, TelemetryMessage, ...
-class task_telemetry : public emblib::task {
+/**
+ * Task which periodically sends the subscribed telemetry streams
+ * @note Telemetry device is usually a channel of the `task_transmitter`
+ */
+class task_telemetry : public task {
+
+    // Frames are limited to what a transmitter channel accepts, the largest
+    // message computed by nanopb with every stream present is much larger
+    static constexpr size_t TELEMETRY_BUFFER_SIZE = task_transmitter::MAX_PAYLOAD_SIZE;
+    // Maximum number of fields with statistics in a stream
+    static constexpr size_t MAX_STREAM_STATS = 3;
+    // Maximum number of tasks whose timing is sent
+    static constexpr size_t MAX_TASK_TIMINGS = std::extent_v<decltype(mp_pb_TelemetryMessage::tasks)>;
+
+    static_assert(TASK_TELEMETRY_FRAME_BUDGET <= TELEMETRY_BUFFER_SIZE, "Telemetry frame budget must fit in a transmitter frame");
+    static_assert(telemetry_compact_batch::MAX_FRAME_SIZE <= task_transmitter::MAX_PAYLOAD_SIZE, "Compact frame must fit in a transmitter frame");
+    static_assert(telemetry_scheduler::STREAM_COUNT <= 32, "Stream bit mask must fit in 32 bits");
 
 public:
     explicit task_telemetry(
         emblib::char_dev& telemetry_device,
-        task_accelerometer& task_accelerometer,
-        task_gyroscope& task_gyroscope,
-        task_state_estimator& task_state_estimator
+        emblib::char_dev& compact_device,
+        accelerometer_channel& accelerometer,
+        gyroscope_channel& gyroscope,
+        task_state_estimator& task_state_estimator,
+        vehicle& vehicle
     );
 
+    /**
+     * Set the rate at which the stream is sent in Hz, 0 disables the stream
+     * @note Can be called from any task
+     */
+    bool subscribe(telemetry_stream_e stream, float rate, telemetry_encoding_e encoding, bool statistics) noexcept
+    {
+        if (!m_scheduler.subscribe(stream, rate, encoding, statistics))
+            return false;
+        // Statistics are owned by the telemetry task, which discards them on its next iteration
+        m_stats_reset_pending.fetch_or(1u << stream);
+        return true;
+    }
+
 private:
     /**
      * Task implementation
      */
-    void run() noexcept override;
+    void run_task() noexcept override;
+
+    /**
+     * Fill the message fields which belong to the stream
+     */
+    void set_stream_fields(mp_pb_TelemetryMessage& msg, telemetry_stream_e stream) noexcept;
+
+    /**
+     * Add the statistics gathered by the producers since
+     * the previous call to the statistics of the stream
+     */
+    void collect_stream_stats(telemetry_stream_e stream) noexcept;
+
+    /**
+     * Take the values of the stream which are gathered in a window by their
+     * producers, restarting the window, and keep them until they're sent
+     */
+    void take_stream_window(telemetry_stream_e stream) noexcept;
+
+    /**
+     * Discard the statistics and the windows of the streams which were
+     * subscribed to since the previous call, including those the producers
+     * gathered while the stream was disabled, so the first message only
+     * covers the new subscription
+     */
+    void reset_subscribed_stats() noexcept;
+
+    /**
+     * Mark the fields which belong to the stream as not present
+     */
+    static void clear_stream_fields(mp_pb_TelemetryMessage& msg, telemetry_stream_e stream) noexcept;
+
+    /**
+     * Add the current sample of the stream to its compact batch
+     */
+    void append_compact_sample(telemetry_stream_e stream) noexcept;
+
+    /**
+     * Send the compact batches which are full, too old, or
+     * whose stream is no longer using the compact encoding
+     */
+    void flush_compact_batches() noexcept;
+
+    /**
+     * Encode the compact batch into a frame and send it
+     */
+    void send_compact_batch(telemetry_compact_batch& batch) noexcept;
+
+    /**
+     * Start sending the encoded frame, first waiting for the
+     * previous frame on the device to be sent if it's still in progress
+     * @note Data must stay valid until the next call to this method
+     * with the same device
+     */
+    void transmit(emblib::char_dev& device, std::atomic<bool>& tx_busy, const char* data, size_t size) noexcept;
 
 private:
     emblib::task_stack_t<TASK_TELEMETRY_STACK_SIZE> m_task_stack;
     emblib::char_dev& m_telemetry_device;
+    telemetry_scheduler m_scheduler;
+
+    // Message being packed, too large for the task stack
+    mp_pb_TelemetryMessage m_msg;
+    // Frames are encoded into one buffer while the other is being sent
+    char m_tx_buffers[2][TELEMETRY_BUFFER_SIZE];
+    size_t m_tx_index;
+    // Is an async write (started from the other buffer) in progress
+    std::atomic<bool> m_tx_busy;
+
+    // Statistics of each stream since it was last sent, kept
+    // here so that they aren't lost if the stream is deferred
+    running_stats3f m_stream_stats[telemetry_scheduler::STREAM_COUNT][MAX_STREAM_STATS];
+    // Bit mask of the streams whose statistics must be reset
+    std::atomic<uint32_t> m_stats_reset_pending;
+
+    // Task timings taken in the last window, taking them restarts the
+    // window in the tasks so they're kept until the stream is sent
+    task_timing_s m_task_timings[MAX_TASK_TIMINGS];
+    size_t m_task_timing_count;
+    // Actuation latency taken in the last window, kept the same way
+    latency_summary_s m_latency;
+    // Bit mask of the streams whose window was taken but not sent yet
+    uint32_t m_unsent_windows;
+
+    // Compact frames are sent through a separate device, double buffered the same way
+    emblib::char_dev& m_compact_device;
+    telemetry_compact_batch m_compact_batches[telemetry_scheduler::STREAM_COUNT];
+    char m_compact_buffers[2][telemetry_compact_batch::MAX_FRAME_SIZE];
+    size_t m_compact_index;
+    std::atomic<bool> m_compact_busy;
 
-    task_accelerometer& m_task_accel;
-    task_gyroscope& m_task_gyro;
+    accelerometer_channel& m_accelerometer;
+    gyroscope_channel& m_gyroscope;
     task_state_estimator& m_task_state;
+    vehicle& m_vehicle;
 };
 
 }
\ No newline at end of file
@@ -1,118 +1,165 @@
 #pragma once
 
+#include "task.hpp"
 #include "task_config.hpp"
+#include "drivers/three_axis_fifo.hpp"
+#include "dsp/fir_decimator.hpp"
+#include "sensors/three_axis_channel.hpp"
 #include "util/logger.hpp"
-#include "util/math.hpp"
+#include "util/time.hpp"
+#include "util/trace.hpp"
 #include <emblib/driver/three_axis_sensor.hpp>
-#include <emblib/rtos/task.hpp>
-#include <emblib/rtos/mutex.hpp>
+#include <cmath>
 
 namespace mp {
 
 /**
- * Template task for reading three axis sensors
- * Allows for raw data correction through the `process` method
+ * Template task for periodically reading three axis sensors
+ * Values are processed and published through the channel of the sensor
+ * Logs of the task are tagged with the given subsystem
+ *
+ * If the sensor has a FIFO, every wake-up reads all the samples taken at
+ * the output data rate since the previous one, and decimates them to the
+ * task rate with an anti-aliasing filter. Otherwise a single sample is read.
+ * The filter delays the decimated samples by `TASK_SENSOR_DECIMATION_TAPS / 2`
+ * task periods, which their timestamps account for.
  */
-template <typename data_type>
-class task_three_axis_sensor : public emblib::task {
+template <typename data_type, log_subsystem_e log_subsystem>
+class task_three_axis_sensor : public task {
+
+    // Largest difference of the rate ratio from a whole number, for rounding errors
+    static constexpr float DECIMATION_RATIO_TOLERANCE = 0.01f;
 
 public:
-    using vector_t = vector<data_type, 3>;
-    using matrix_t = matrix<data_type, 3>;
+    using channel_t = three_axis_channel<data_type>;
+    using vector_t = typename channel_t::vector_t;
 
+    /**
+     * @param channel Published to at the task rate
+     * @param fifo FIFO of the same sensor, `nullptr` to read single samples
+     */
     explicit task_three_axis_sensor(
         emblib::three_axis_sensor<data_type>& sensor,
+        channel_t& channel,
         const char* task_name,
         task_priority_e task_priority,
-        emblib::ticks_t task_period
+        emblib::ticks_t task_period,
+        three_axis_fifo<data_type>* fifo
     ) :
         task(task_name, task_priority, m_task_stack),
+        m_task_period(task_period),
         m_sensor(sensor),
-        m_task_period(task_period)
-    {}
-
-    /**
-     * Get last read raw value
-     */
-    vector_t get_raw() noexcept
+        m_channel(channel),
+        m_fifo(fifo)
     {
-        emblib::scoped_lock lock{m_read_mutex};
-        return m_last_raw;
-    }
-
-    /**
-     * Get last corrected value
-     */
-    vector_t get_corrected() noexcept
-    {
-        emblib::scoped_lock lock{m_read_mutex};
-        return m_last_corrected;
+        if (!m_fifo)
+            return;
+
+        // Output data rate must be a whole multiple of the task rate,
+        // otherwise the outputs would drift against the task period
+        const float task_rate = 1.f / std::chrono::duration<float>(m_task_period).count();
+        const float ratio = m_fifo->get_output_data_rate() / task_rate;
+        const float factor = std::round(ratio);
+        if (factor < 1.f || std::fabs(ratio - factor) > DECIMATION_RATIO_TOLERANCE ||
+            !m_decimator.configure(static_cast<size_t>(factor))) {
+            MP_LOGS_WARNING(log_subsystem, "Sensor FIFO rate not supported, reading single samples");
+            m_fifo = nullptr;
+        }
     }
 
+private:
     /**
-     * Get the noise variance matrix based on the sensor noise
-     * density and the sampling frequency
-     * TODO: This can be moved to the sensor itself, based on
-     * the output data rate which it can track
-     * TODO: Change the matrix scalar type to data_type/sqrt(Hz)
+     * Task thread
      */
-    matrix3f get_noise_variance() const noexcept
-    {
-        // TODO: Change this to sensor output data rate
-        float fs = 1.f / std::chrono::duration<float>(m_task_period).count();
-
-        float noise_density = m_sensor.get_noise_density();
-        float noise_variance = fs * noise_density * noise_density;
-        return matrix3f::diagonal(noise_variance);
-    }
+    void run_task() noexcept override;
 
-    /// @todo Add calculate_bias method
-
-private:
     /**
-     * Apply processing to the raw input value
-     * This can be a filter, bias subtraction, ...
+     * Read and publish a single sample
      */
-    virtual vector_t process(const vector_t& raw_data) const noexcept = 0;
+    void read_single() noexcept;
 
     /**
-     * Task thread
+     * Read and decimate all the samples in the FIFO
      */
-    void run() noexcept override;
+    void read_fifo() noexcept;
 
 private:
     emblib::task_stack_t<512> m_task_stack;
     emblib::ticks_t m_task_period;
     emblib::three_axis_sensor<data_type>& m_sensor;
-    
-    emblib::mutex m_read_mutex;
-    vector_t m_last_raw;
-    vector_t m_last_corrected;
+    channel_t& m_channel;
+
+    three_axis_fifo<data_type>* m_fifo;
+    fir_decimator3<TASK_SENSOR_DECIMATION_TAPS, TASK_SENSOR_MAX_DECIMATION> m_decimator;
+    // Kept off the stack of the task
+    data_type m_burst[TASK_SENSOR_FIFO_MAX_BURST][3];
 };
 
 /**
  * Task implementation
  */
-template <typename data_type>
-inline void task_three_axis_sensor<data_type>::run() noexcept
+template <typename data_type, log_subsystem_e log_subsystem>
+inline void task_three_axis_sensor<data_type, log_subsystem>::run_task() noexcept
 {
     // This task should only be created for valid sensors
     // so assert that the sensor is actually working
     assert(m_sensor.probe());
 
-    data_type read_data[3];
     while (true) {
-        if (m_sensor.read_all_axes(read_data)) {
-            emblib::scoped_lock lock(m_read_mutex);
-            m_last_raw = vector_t {read_data[0], read_data[1], read_data[2]};
-            m_last_corrected = process(m_last_raw);
-        } else {
-            // TODO: Add information about sensor type to the log
-            log_warning("Sensor reading failed");
+        {
+            MP_TRACE_SCOPE("sensor read");
+            if (m_fifo)
+                read_fifo();
+            else
+                read_single();
         }
 
         sleep_periodic(m_task_period);
     }
 }
 
-}
\ No newline at end of file
+template <typename data_type, log_subsystem_e log_subsystem>
+inline void task_three_axis_sensor<data_type, log_subsystem>::read_single() noexcept
+{
+    data_type read_data[3];
+    // Taken before the read, so the age of the data includes the bus transfer
+    const uint64_t timestamp_us = get_time_us();
+    if (m_sensor.read_all_axes(read_data)) {
+        m_channel.publish(vector_t {read_data[0], read_data[1], read_data[2]}, timestamp_us);
+    } else {
+        MP_LOGS_WARNING_THROTTLED(log_subsystem, std::chrono::seconds(1), "Sensor reading failed");
+    }
+}
+
+template <typename data_type, log_subsystem_e log_subsystem>
+inline void task_three_axis_sensor<data_type, log_subsystem>::read_fifo() noexcept
+{
+    // Newest sample in the FIFO was taken at most one sample period before this
+    const uint64_t read_us = get_time_us();
+    size_t count;
+    size_t remaining;
+    if (!m_fifo->read_fifo(m_burst, TASK_SENSOR_FIFO_MAX_BURST, count, remaining)) {
+        MP_LOGS_WARNING_THROTTLED(log_subsystem, std::chrono::seconds(1), "Sensor FIFO reading failed");
+        return;
+    }
+
+    // Samples left for the next wake-up are newer than the whole burst
+    const float sample_period_us = 1e6f / m_fifo->get_output_data_rate();
+    const float delay_us = m_decimator.get_group_delay() * sample_period_us;
+    for (size_t i = 0; i < count; i++) {
+        const float input[3] = {
+            static_cast<float>(m_burst[i][0]),
+            static_cast<float>(m_burst[i][1]),
+            static_cast<float>(m_burst[i][2])
+        };
+        float output[3];
+        if (!m_decimator.process(input, output))
+            continue;
+
+        // Output is stamped with the time of the input at the center of the filter
+        const uint64_t timestamp_us = read_us - static_cast<uint64_t>((count - 1 - i + remaining) * sample_period_us + delay_us);
+        m_channel.publish(vector_t {output[0], output[1], output[2]}, timestamp_us);
+    }
+}
+
+}
@@ -0,0 +1,179 @@
+#include "task_transmitter.hpp"
+#include "util/time.hpp"
+#include "util/trace.hpp"
+#include <cstring>
+
+namespace mp {
+
+ssize_t task_transmitter::channel::write(const char* data, size_t size, milliseconds_t timeout) noexcept
+{
+    if (size > MAX_PAYLOAD_SIZE)
+        return -1;
+
+    char header[FRAME_HEADER_SIZE];
+    write_header(header, m_frame_type, size);
+
+    emblib::char_dev& device = m_transmitter->m_output_device;
+    if (device.write(header, sizeof(header), timeout) != static_cast<ssize_t>(sizeof(header)))
+        return -1;
+    return device.write(data, size, timeout);
+}
+
+bool task_transmitter::channel::probe(milliseconds_t timeout) noexcept
+{
+    return m_transmitter->m_output_device.probe(timeout);
+}
+
+bool task_transmitter::channel::write_async(const char* data, size_t size, const callback_t& callback) noexcept
+{
+    if (size > MAX_PAYLOAD_SIZE)
+        return false;
+    // Claimed first, so the transmitter only sees the message once it's complete
+    state_e expected = state_e::IDLE;
+    if (!m_state.compare_exchange_strong(expected, state_e::CLAIMED))
+        return false;
+
+    m_data = data;
+    m_size = size;
+    m_callback = callback;
+    m_state.store(state_e::PENDING);
+
+    m_transmitter->notify();
+    return true;
+}
+
+task_transmitter::task_transmitter(emblib::char_dev& output_device) noexcept :
+    task("Task transmitter", TASK_TRANSMITTER_PRIORITY, m_task_stack),
+    m_output_device(output_device),
+    m_transfer_size(0),
+    m_transfer_offset(0),
+    m_transfer_active(false)
+{
+    static constexpr mp_pb_FrameType CHANNEL_FRAME_TYPES[TRANSMITTER_CHANNEL_COUNT] = {
+        mp_pb_FrameType_FRAME_TYPE_ACK,
+        mp_pb_FrameType_FRAME_TYPE_PARAM,
+        mp_pb_FrameType_FRAME_TYPE_TELEMETRY_COMPACT,
+        mp_pb_FrameType_FRAME_TYPE_TELEMETRY,
+        mp_pb_FrameType_FRAME_TYPE_LOG_BINARY,
+        mp_pb_FrameType_FRAME_TYPE_LOG
+    };
+
+    for (size_t i = 0; i < TRANSMITTER_CHANNEL_COUNT; i++) {
+        m_channels[i].m_transmitter = this;
+        m_channels[i].m_frame_type = CHANNEL_FRAME_TYPES[i];
+    }
+}
+
+void task_transmitter::write_header(char* buffer, mp_pb_FrameType type, size_t size) noexcept
+{
+    buffer[0] = FRAME_SYNC;
+    buffer[1] = static_cast<char>(type);
+    buffer[2] = static_cast<char>(size & 0xFF);
+    buffer[3] = static_cast<char>((size >> 8) & 0xFF);
+}
+
+bool task_transmitter::start_transfer() noexcept
+{
+    MP_TRACE_SCOPE("transmit");
+    size_t transfer_size = 0;
+
+    // Channels are ordered by priority, so if not all pending frames
+    // fit, the lower priority ones are left for the next transfer
+    for (channel& ch : m_channels) {
+        if (ch.m_state.load() != channel::state_e::PENDING)
+            continue;
+
+        const size_t frame_size = FRAME_HEADER_SIZE + ch.m_size;
+        if (frame_size > sizeof(m_transfer_buffer) - transfer_size)
+            continue;
+
+        write_header(m_transfer_buffer + transfer_size, ch.m_frame_type, ch.m_size);
+        memcpy(m_transfer_buffer + transfer_size + FRAME_HEADER_SIZE, ch.m_data, ch.m_size);
+        transfer_size += frame_size;
+        ch.m_state.store(channel::state_e::IN_TRANSFER);
+    }
+
+    if (transfer_size == 0)
+        return false;
+
+    m_transfer_size = transfer_size;
+    m_transfer_offset = 0;
+    m_transfer_active.store(true);
+    continue_transfer(false);
+    return true;
+}
+
+void task_transmitter::continue_transfer(bool from_isr) noexcept
+{
+    if (m_output_device.is_async_available()) {
+        const char* data = m_transfer_buffer + m_transfer_offset;
+        const size_t size = m_transfer_size - m_transfer_offset;
+        if (!m_output_device.write_async(data, size, [this](ssize_t status) { on_write_done(status); }))
+            complete_transfer(-1, from_isr);
+        return;
+    }
+
+    // Nothing written within the timeout is a failure, so the task never spins
+    while (m_transfer_offset < m_transfer_size) {
+        const ssize_t status = m_output_device.write(
+            m_transfer_buffer + m_transfer_offset,
+            m_transfer_size - m_transfer_offset,
+            TASK_TRANSMITTER_WRITE_TIMEOUT
+        );
+        if (status <= 0) {
+            complete_transfer(-1, from_isr);
+            return;
+        }
+        m_transfer_offset += status;
+    }
+    complete_transfer(static_cast<ssize_t>(m_transfer_size), from_isr);
+}
+
+void task_transmitter::on_write_done(ssize_t status) noexcept
+{
+    if (status < 0) {
+        complete_transfer(status, true);
+        return;
+    }
+
+    // Devices can accept only a part of the data, the rest is written next
+    m_transfer_offset += status;
+    if (m_transfer_offset < m_transfer_size)
+        continue_transfer(true);
+    else
+        complete_transfer(static_cast<ssize_t>(m_transfer_size), true);
+}
+
+void task_transmitter::complete_transfer(ssize_t status, bool from_isr) noexcept
+{
+    // Frames are only reported once the whole transfer is written
+    for (channel& ch : m_channels) {
+        if (ch.m_state.load() != channel::state_e::IN_TRANSFER)
+            continue;
+
+        ch.m_state.store(channel::state_e::IDLE);
+        ch.m_callback(status < 0 ? status : static_cast<ssize_t>(ch.m_size));
+    }
+
+    m_transfer_active.store(false);
+    if (from_isr)
+        notify_from_isr();
+    else
+        notify();
+}
+
+void task_transmitter::run_task() noexcept
+{
+    while (true) {
+        // Woken up by the channels when a new frame is pending
+        // and by the output device once the transfer is done
+        wait_notification();
+
+        begin_iteration(get_time_us());
+        if (!m_transfer_active.load())
+            start_transfer();
+        end_iteration(0);
+    }
+}
+
+}
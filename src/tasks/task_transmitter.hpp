@@ -0,0 +1,173 @@
+#pragma once
+
+#include "task.hpp"
+#include "task_config.hpp"
+#include "pb/frame.pb.h"
+#include <emblib/driver/char_dev.hpp>
+#include <atomic>
+
+namespace mp {
+
+/**
+ * Output channels of the transmitter, ordered by priority
+ * (lower value is sent first)
+ */
+enum transmitter_channel_e : size_t {
+    TRANSMITTER_CHANNEL_ACK = 0,
+    TRANSMITTER_CHANNEL_PARAM,
+    TRANSMITTER_CHANNEL_TELEMETRY_COMPACT,
+    TRANSMITTER_CHANNEL_TELEMETRY,
+    TRANSMITTER_CHANNEL_LOG_BINARY,
+    TRANSMITTER_CHANNEL_LOG,
+    TRANSMITTER_CHANNEL_COUNT
+};
+
+/**
+ * Task which owns the output device and multiplexes messages
+ * of different types (telemetry, logs, acks) over it
+ *
+ * Each message type is written through its own channel which is a
+ * `char_dev`, so the producers don't need to know if the output device is
+ * shared. Every message is wrapped into a frame (see frame.proto) and all
+ * pending frames are coalesced into a single transfer, taking them from the
+ * channels in the order of priority. This way a burst of logs can only
+ * delay telemetry by the duration of a single transfer.
+ *
+ * Transfers are async if the output device supports it, otherwise the
+ * task writes them synchronously. A partial write is continued with the
+ * remaining bytes, so frames are never cut on the output.
+ */
+class task_transmitter : public task {
+
+public:
+    using milliseconds_t = emblib::milliseconds;
+
+    // Sync byte + frame type + payload length
+    static constexpr size_t FRAME_HEADER_SIZE = 4;
+    static constexpr char FRAME_SYNC = static_cast<char>(0xA5);
+    // Largest payload which can be written through a channel
+    static constexpr size_t MAX_PAYLOAD_SIZE = TASK_TRANSMITTER_BUFFER_SIZE - FRAME_HEADER_SIZE;
+
+    /**
+     * Char dev through which messages of a single type are sent
+     *
+     * Only a single async write can be in progress per channel. The write
+     * callback is called from the output device's callback once the
+     * message has been sent.
+     */
+    class channel : public emblib::char_dev {
+
+        friend class task_transmitter;
+
+    public:
+        /**
+         * Write the frame directly to the output device
+         * @note This bypasses the transmitter task so it should only be
+         * used before the scheduler is started
+         */
+        ssize_t write(const char* data, size_t size, milliseconds_t timeout = milliseconds_t(0)) noexcept override;
+
+        /**
+         * Reading not supported for the output channels
+         */
+        ssize_t read(char* buffer, size_t size, milliseconds_t timeout = milliseconds_t(0)) noexcept override
+        {
+            UNUSED(buffer);
+            UNUSED(size);
+            return -1;
+        }
+
+        bool probe(milliseconds_t timeout) noexcept override;
+
+        bool is_async_available() noexcept override
+        {
+            return true;
+        }
+
+        /**
+         * Queue the message to be sent by the transmitter task
+         * @returns false if the channel is busy or the message is too large
+         * @note Data must stay valid until the callback is called
+         */
+        bool write_async(const char* data, size_t size, const callback_t& callback) noexcept override;
+
+    private:
+        enum class state_e : uint8_t {
+            IDLE,
+            // Claimed by a writer which is filling in the message
+            CLAIMED,
+            // Waiting to be picked up by the transmitter
+            PENDING,
+            // Part of the transfer in progress
+            IN_TRANSFER
+        };
+
+        task_transmitter* m_transmitter = nullptr;
+        mp_pb_FrameType m_frame_type = mp_pb_FrameType_FRAME_TYPE_LOG;
+
+        std::atomic<state_e> m_state {state_e::IDLE};
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+        callback_t m_callback;
+    };
+
+public:
+    explicit task_transmitter(emblib::char_dev& output_device) noexcept;
+
+    /**
+     * Get the channel through which messages of the given type are sent
+     */
+    channel& get_channel(transmitter_channel_e channel) noexcept
+    {
+        return m_channels[channel];
+    }
+
+private:
+    /**
+     * Task implementation
+     */
+    void run_task() noexcept override;
+
+    /**
+     * Copy all pending frames into the transfer buffer and start the transfer
+     * @returns false if there was nothing to send or the transfer didn't start
+     */
+    bool start_transfer() noexcept;
+
+    /**
+     * Write the rest of the transfer, asynchronously if the output device supports it
+     * @param from_isr Is this called from the output device callback
+     */
+    void continue_transfer(bool from_isr) noexcept;
+
+    /**
+     * Called from the async write callback with the number of bytes written
+     */
+    void on_write_done(ssize_t status) noexcept;
+
+    /**
+     * Complete all the channels in the transfer and wake up the task
+     * @param status Negative if the transfer failed
+     * @param from_isr Is this called from the output device callback
+     */
+    void complete_transfer(ssize_t status, bool from_isr) noexcept;
+
+    /**
+     * Write the frame header into the buffer
+     */
+    static void write_header(char* buffer, mp_pb_FrameType type, size_t size) noexcept;
+
+private:
+    emblib::task_stack_t<TASK_TRANSMITTER_STACK_SIZE> m_task_stack;
+    emblib::char_dev& m_output_device;
+
+    channel m_channels[TRANSMITTER_CHANNEL_COUNT];
+
+    char m_transfer_buffer[TASK_TRANSMITTER_BUFFER_SIZE];
+    size_t m_transfer_size;
+    // Bytes of the transfer already written
+    size_t m_transfer_offset;
+    std::atomic<bool> m_transfer_active;
+};
+
+}
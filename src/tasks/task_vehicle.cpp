@@ -1,24 +1,209 @@
 #include "task_vehicle.hpp"
+#include "params/param_store.hpp"
+#include "util/byte_order.hpp"
 #include "util/logger.hpp"
+#include "util/pb_util.hpp"
+#include "util/time.hpp"
+#include "util/trace.hpp"
 #include "pb/command.pb.h"
+#include <pb_encode.h>
+#include <cstring>
 
 namespace mp {
 
-// Conversion of the task period to floating point delta time
-static constexpr float DT = std::chrono::duration<float>(TASK_VEHICLE_PERIOD).count();
+static constexpr uint64_t LATENCY_REPORT_PERIOD_US = std::chrono::microseconds(TASK_VEHICLE_LATENCY_REPORT_PERIOD).count();
+
+// Maximum number of parameters in a single report
+static constexpr size_t PARAM_REPORT_MAX_VALUES = sizeof(mp_pb_ParamReport::values) / sizeof(mp_pb_ParamValue);
+
+static bool set_param(param_id_e id, const mp_pb_ParamCommandSet& set) noexcept
+{
+    param_store& params = param_store::get_instance();
+    switch (set.which_value) {
+    case mp_pb_ParamCommandSet_float_value_tag:
+        return params.set_float(id, set.value.float_value);
+    case mp_pb_ParamCommandSet_int_value_tag:
+        return params.set_int(id, set.value.int_value);
+    case mp_pb_ParamCommandSet_bool_value_tag:
+        return params.set_bool(id, set.value.bool_value);
+    default:
+        return false;
+    }
+}
 
 task_vehicle::task_vehicle(
     vehicle& vehicle,
     task_receiver& task_receiver,
-    task_state_estimator& task_state_estimator
+    task_state_estimator& task_state_estimator,
+    task_telemetry* task_telemetry,
+    emblib::char_dev* ack_device,
+    emblib::char_dev* param_device
 ) noexcept :
     task("Task vehicle", TASK_VEHICLE_PRIORITY, m_task_stack),
     m_vehicle(vehicle),
     m_task_receiver(task_receiver),
-    m_task_state_estimator(task_state_estimator)
-{}
+    m_task_state_estimator(task_state_estimator),
+    m_task_telemetry(task_telemetry),
+    m_ack_device(ack_device),
+    m_ack_count(0),
+    m_ack_busy(false),
+    m_param_device(param_device),
+    m_param_busy(false),
+    m_latency_report_us(0),
+    m_rc_sequence(0),
+    m_rc_received(false)
+{
+    if (TASK_VEHICLE_WAKE_ON_COMMAND)
+        task_receiver.set_listener(this);
+}
+
+bool task_vehicle::handle_global_command(const mp_pb_Command& command) noexcept
+{
+    switch (command.which_command_type) {
+    case mp_pb_Command_telemetry_subscribe_tag: {
+        if (!m_task_telemetry)
+            return false;
+        const auto& subscribe = command.command_type.telemetry_subscribe;
+        return m_task_telemetry->subscribe(subscribe.stream, subscribe.rate, subscribe.encoding, subscribe.statistics);
+    }
+    case mp_pb_Command_log_set_mask_tag: {
+        const auto& set_mask = command.command_type.log_set_mask;
+        return logger::get_instance().set_subsystem_mask(set_mask.subsystem, static_cast<uint8_t>(set_mask.level_mask));
+    }
+    case mp_pb_Command_param_get_tag: {
+        param_id_e id;
+        if (!param_store::find(command.command_type.param_get.id, id))
+            return false;
+        return send_param_report(id, 1);
+    }
+    case mp_pb_Command_param_set_tag: {
+        const auto& set = command.command_type.param_set;
+        param_id_e id;
+        if (!param_store::find(set.id, id) || !set_param(id, set))
+            return false;
+        // Set is acked as successful even if the new value can't be reported
+        send_param_report(id, 1);
+        return true;
+    }
+    case mp_pb_Command_param_list_tag:
+        return send_param_report(command.command_type.param_list.offset, PARAM_REPORT_MAX_VALUES);
+    case mp_pb_Command_param_save_tag:
+        return param_store::get_instance().save();
+    default:
+        return false;
+    }
+}
+
+bool task_vehicle::send_param_report(size_t offset, size_t count) noexcept
+{
+    if (!m_param_device || m_param_busy.load())
+        return false;
+
+    mp_pb_ParamReport report = mp_pb_ParamReport_init_zero;
+    report.offset = offset;
+    report.total_count = PARAM_COUNT;
+    for (size_t i = offset; i < PARAM_COUNT && report.values_count < count; i++)
+        pb_param_value_set(report.values[report.values_count++], static_cast<param_id_e>(i));
+
+    pb_ostream_t ostream = pb_ostream_from_buffer(reinterpret_cast<uint8_t*>(m_param_buffer), sizeof(m_param_buffer));
+    if (!pb_encode(&ostream, mp_pb_ParamReport_fields, &report))
+        return false;
+
+    m_param_busy.store(true);
+    bool start_status = m_param_device->write_async(m_param_buffer, ostream.bytes_written, [this](ssize_t status) {
+        m_param_busy.store(false);
+    });
+
+    if (!start_status)
+        m_param_busy.store(false);
+    return start_status;
+}
+
+void task_vehicle::queue_ack(const received_command_s& received, uint64_t apply_time_us, mp_pb_CommandResult result) noexcept
+{
+    if (!m_ack_device)
+        return;
+
+    if (m_ack_count == TASK_VEHICLE_ACK_QUEUE_SIZE) {
+        MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_VEHICLE, std::chrono::seconds(1), "Vehicle ack dropped: ", received.command.sequence);
+        return;
+    }
+
+    uint8_t* out = m_ack_queue + m_ack_count * ACK_RECORD_SIZE;
+    out = put_int<uint32_t>(out, received.command.sequence);
+    out = put_int<uint32_t>(out, received.command.send_time);
+    out = put_int<uint32_t>(out, static_cast<uint32_t>(received.receive_time_us));
+    out = put_int<uint32_t>(out, static_cast<uint32_t>(apply_time_us));
+    out = put_int<uint8_t>(out, static_cast<uint8_t>(result));
+    m_ack_count++;
+}
 
-void task_vehicle::run() noexcept
+void task_vehicle::send_acks() noexcept
+{
+    if (m_ack_count == 0 || m_ack_busy.load())
+        return;
+
+    // Acks are copied out so that the new ones can
+    // be queued while the frame is being sent
+    const size_t size = m_ack_count * ACK_RECORD_SIZE;
+    memcpy(m_ack_buffer, m_ack_queue, size);
+    m_ack_count = 0;
+
+    m_ack_busy.store(true);
+    bool start_status = m_ack_device->write_async(m_ack_buffer, size, [this](ssize_t status) {
+        m_ack_busy.store(false);
+    });
+
+    if (!start_status) {
+        m_ack_busy.store(false);
+        MP_LOGS_WARNING_THROTTLED(mp_pb_Subsystem_SUBSYSTEM_VEHICLE, std::chrono::seconds(1), "Vehicle ack send failed!");
+    }
+}
+
+void task_vehicle::update_rc_input() noexcept
+{
+    rc_input_s input;
+    if (!param_store::get_instance().get<PARAM_RC_ENABLED>() || !m_task_receiver.get_rc_input(input))
+        return;
+    if (m_rc_received && input.sequence == m_rc_sequence)
+        return;
+
+    m_rc_sequence = input.sequence;
+    m_rc_received = true;
+    m_vehicle.handle_rc_input(input);
+}
+
+void task_vehicle::handle_commands() noexcept
+{
+    MP_TRACE_SCOPE("commands");
+    received_command_s received;
+    while (m_task_receiver.get_command(received)) {
+        const uint64_t apply_time_us = get_time_us();
+        m_residence_stats.add((apply_time_us - received.receive_time_us) / 1000.f);
+
+        // If false is returned, this command was either rejected or
+        // not for this vehicle, so try to handle it globally
+        const bool status = m_vehicle.handle_command(received.command) || handle_global_command(received.command);
+        queue_ack(received, apply_time_us, status ? mp_pb_CommandResult_COMMAND_RESULT_OK : mp_pb_CommandResult_COMMAND_RESULT_FAILED);
+    }
+    send_acks();
+}
+
+void task_vehicle::report_latency(uint64_t now_us) noexcept
+{
+    if (now_us - m_latency_report_us < LATENCY_REPORT_PERIOD_US)
+        return;
+    m_latency_report_us = now_us;
+
+    const auto stats = m_residence_stats.take();
+    if (stats.get_count() == 0)
+        return;
+    MP_LOGS_INFO(mp_pb_Subsystem_SUBSYSTEM_VEHICLE, "Command residence mean ms: ", stats.get_mean()(0));
+    MP_LOGS_INFO(mp_pb_Subsystem_SUBSYSTEM_VEHICLE, "Command residence max ms: ", stats.get_max()(0));
+    MP_LOGS_INFO(mp_pb_Subsystem_SUBSYSTEM_VEHICLE, "Command residence count: ", stats.get_count());
+}
+
+void task_vehicle::run_task() noexcept
 {
     // Vehicle's init must complete successfully for
     // the rest of the system to run as intended
@@ -27,21 +212,46 @@ void task_vehicle::run() noexcept
         assert(false);
     }
 
+    const param_store& params = param_store::get_instance();
+    uint64_t next_update_us = get_time_us();
+    m_latency_report_us = next_update_us;
+
     while (true) {
-        // See if there are any commands available and execute them
-        // before running the next iteration of the update loop
-        mp_pb_Command recv_command;
-        while (m_task_receiver.get_command(recv_command)) {            
-            // TODO: If false is returned, this command was not for this
-            // vehicle, try to handle it globally
-            m_vehicle.handle_command(recv_command);
+        // Commands are handled whenever the task wakes up,
+        // before the update if it's also due
+        handle_commands();
+
+        const uint64_t now_us = get_time_us();
+        if (now_us >= next_update_us) {
+            begin_iteration(next_update_us);
+
+            // Period can change at runtime, and takes effect from the next update
+            const uint64_t period_us = params.get<PARAM_VEHICLE_PERIOD_MS>() * 1000;
+            const float dt = period_us * 1e-6f;
+
+            // Stick input is applied after the commands, so it overrides
+            // any target set by them in the same iteration
+            update_rc_input();
+
+            state_s state = m_task_state_estimator.get_state();
+            m_vehicle.update(state, dt);
+            end_iteration(period_us);
+
+            // Deadlines stay on the same cadence, unless the update
+            // overran a whole period in which case the missed ones are skipped
+            next_update_us += period_us;
+            if (next_update_us <= now_us)
+                next_update_us = now_us + period_us;
+
+            report_latency(now_us);
         }
-        
-        state_s state = m_task_state_estimator.get_state();
-        m_vehicle.update(state, DT);
 
-        sleep_periodic(TASK_VEHICLE_PERIOD);
+        // Woken up early by the receiver, or times out at the next deadline,
+        // and if the deadline already passed the difference wraps around
+        const uint64_t wait_us = next_update_us - get_time_us();
+        if (wait_us <= next_update_us - now_us)
+            wait_notification(std::chrono::ceil<emblib::ticks_t>(std::chrono::microseconds(wait_us)));
     }
 }
 
-}
\ No newline at end of file
+}
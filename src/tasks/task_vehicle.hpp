@@ -1,28 +1,87 @@
 #pragma once
 
+#include "task.hpp"
 #include "task_config.hpp"
 #include "vehicles/vehicle.hpp"
 #include "task_receiver.hpp"
 #include "task_state_estimator.hpp"
+#include "task_telemetry.hpp"
+#include "util/running_stats.hpp"
+#include "pb/command.pb.h"
+#include "pb/param.pb.h"
+#include <emblib/driver/char_dev.hpp>
+#include <atomic>
 
 namespace mp {
 
 /**
  * Task responsible for running the vehicle update iterations
  * and passing the received commands to the vehicle for processing
+ *
+ * Every command is acknowledged with its result and the times it was
+ * received and applied (see FRAME_TYPE_ACK in frame.proto). Acks are
+ * collected during an iteration and sent as a single frame without
+ * waiting for the device, if it's busy they are sent in the next one.
+ *
+ * The receiver wakes the task up as soon as a command arrives, so commands
+ * are handled right away instead of waiting for the next iteration. The
+ * updates still run on a fixed cadence, with deadlines measured from the
+ * start of the task, and their period is the vehicle.period_ms parameter.
  * @todo Should be the only task with a reference to the vehicle
  */
-class task_vehicle : public emblib::task {
+class task_vehicle : public task {
+
+    static constexpr size_t ACK_RECORD_SIZE = 17;
 
 public:
     explicit task_vehicle(
         vehicle& vehicle,
         task_receiver& task_receiver,
-        task_state_estimator& task_state_estimator
+        task_state_estimator& task_state_estimator,
+        task_telemetry* task_telemetry,
+        emblib::char_dev* ack_device,
+        emblib::char_dev* param_device
     ) noexcept;
 
 private:
-    void run() noexcept override;
+    void run_task() noexcept override;
+
+    /**
+     * Handle commands which are not vehicle specific
+     * @returns false if the command is unknown
+     */
+    bool handle_global_command(const mp_pb_Command& command) noexcept;
+
+    /**
+     * Report the values of the parameters starting at the offset
+     * @returns false if the previous report is still being sent
+     */
+    bool send_param_report(size_t offset, size_t count) noexcept;
+
+    /**
+     * Add the acknowledgment of the applied command to the next ack frame
+     */
+    void queue_ack(const received_command_s& received, uint64_t apply_time_us, mp_pb_CommandResult result) noexcept;
+
+    /**
+     * Send the queued acks if the previous frame was already sent
+     */
+    void send_acks() noexcept;
+
+    /**
+     * Apply all the received commands and send their acks
+     */
+    void handle_commands() noexcept;
+
+    /**
+     * Periodically log the time commands spend in the receiver queue
+     */
+    void report_latency(uint64_t now_us) noexcept;
+
+    /**
+     * Pass the latest stick input to the vehicle if it changed since the last iteration
+     */
+    void update_rc_input() noexcept;
 
 private:
     emblib::task_stack_t<TASK_VEHICLE_STACK_SIZE> m_task_stack;
@@ -30,6 +89,29 @@ private:
 
     task_receiver& m_task_receiver;
     task_state_estimator& m_task_state_estimator;
+    // Optional, `nullptr` if telemetry is not available
+    task_telemetry* m_task_telemetry;
+
+    // Optional, `nullptr` if acks are not sent
+    emblib::char_dev* m_ack_device;
+    uint8_t m_ack_queue[TASK_VEHICLE_ACK_QUEUE_SIZE * ACK_RECORD_SIZE];
+    size_t m_ack_count;
+    // Frame being sent, valid until the write callback
+    char m_ack_buffer[TASK_VEHICLE_ACK_QUEUE_SIZE * ACK_RECORD_SIZE];
+    std::atomic<bool> m_ack_busy;
+
+    // Optional, `nullptr` if parameter reports are not sent
+    emblib::char_dev* m_param_device;
+    char m_param_buffer[mp_pb_ParamReport_size];
+    std::atomic<bool> m_param_busy;
+
+    // Time from receiving a command to applying it, in milliseconds
+    running_stats<float, 1> m_residence_stats;
+    uint64_t m_latency_report_us;
+
+    // Sequence number of the last applied stick input
+    uint16_t m_rc_sequence;
+    bool m_rc_received;
 };
 
 }
\ No newline at end of file
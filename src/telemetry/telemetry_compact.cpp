@@ -0,0 +1,114 @@
+#include "telemetry_compact.hpp"
+#include "util/byte_order.hpp"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace mp {
+
+// Round and saturate the scaled value to the range of the integer type
+template <typename int_type>
+static int_type quantize(float value, float scale) noexcept
+{
+    constexpr float min = std::numeric_limits<int_type>::min();
+    constexpr float max = std::numeric_limits<int_type>::max();
+
+    const float scaled = std::round(value * scale);
+    if (!(scaled > min))
+        return std::numeric_limits<int_type>::min();
+    if (scaled >= max)
+        return std::numeric_limits<int_type>::max();
+    return static_cast<int_type>(scaled);
+}
+
+template <typename int_type>
+static uint8_t* put_vector(uint8_t* out, const vector3f& vec, float scale) noexcept
+{
+    for (size_t i = 0; i < 3; i++)
+        out = put_int(out, quantize<int_type>(vec(i), scale));
+    return out;
+}
+
+static uint32_t pack_quaternion(const quaternionf& q) noexcept
+{
+    static constexpr float COMPONENT_SCALE = 511.f * static_cast<float>(M_SQRT2);
+
+    const vector4f qv = q.as_vector();
+    size_t largest = 0;
+    for (size_t i = 1; i < 4; i++) {
+        if (std::fabs(qv(i)) > std::fabs(qv(largest)))
+            largest = i;
+    }
+
+    // q and -q are the same rotation, so the largest
+    // component is always made positive and not sent
+    const float sign = qv(largest) < 0 ? -1.f : 1.f;
+    uint32_t packed = static_cast<uint32_t>(largest) << 30;
+    size_t shift = 20;
+    for (size_t i = 0; i < 4; i++) {
+        if (i == largest)
+            continue;
+        float component = sign * qv(i) * COMPONENT_SCALE;
+        component = component > 511.f ? 511.f : (component < -511.f ? -511.f : component);
+        packed |= (static_cast<uint32_t>(static_cast<int32_t>(std::round(component))) & 0x3FF) << shift;
+        shift -= 10;
+    }
+    return packed;
+}
+
+void telemetry_compact_batch::start(uint64_t timestamp_us, uint32_t period_us) noexcept
+{
+    m_timestamp_us = timestamp_us;
+    m_period_us = period_us;
+    m_count = 0;
+    m_size = 0;
+}
+
+void telemetry_compact_batch::append_state(const state_s& state) noexcept
+{
+    if (is_full())
+        return;
+
+    uint8_t* out = m_samples + m_size;
+    if (m_stream == mp_pb_TelemetryStream_TELEMETRY_STREAM_ATTITUDE) {
+        out = put_int(out, pack_quaternion(state.rotationq));
+        out = put_vector<int16_t>(out, state.angular_velocity, TELEMETRY_COMPACT_ANGULAR_VELOCITY_SCALE);
+    } else {
+        out = put_vector<int32_t>(out, state.position, TELEMETRY_COMPACT_POSITION_SCALE);
+        out = put_vector<int16_t>(out, state.velocity, TELEMETRY_COMPACT_VELOCITY_SCALE);
+        out = put_vector<int16_t>(out, state.acceleration, TELEMETRY_COMPACT_ACCELERATION_SCALE);
+    }
+    m_size = out - m_samples;
+    m_count++;
+}
+
+void telemetry_compact_batch::append_sensor_data(const vector3f& acc, const vector3f& gyro) noexcept
+{
+    if (is_full())
+        return;
+
+    uint8_t* out = m_samples + m_size;
+    out = put_vector<int16_t>(out, acc, TELEMETRY_COMPACT_ACCELERATION_SCALE);
+    out = put_vector<int16_t>(out, gyro, TELEMETRY_COMPACT_ANGULAR_VELOCITY_SCALE);
+    m_size = out - m_samples;
+    m_count++;
+}
+
+size_t telemetry_compact_batch::encode_frame(char (&frame)[MAX_FRAME_SIZE]) noexcept
+{
+    uint8_t* out = reinterpret_cast<uint8_t*>(frame);
+    out = put_int<uint8_t>(out, TELEMETRY_COMPACT_VERSION);
+    out = put_int<uint8_t>(out, static_cast<uint8_t>(m_stream));
+    out = put_int<uint16_t>(out, m_sequence++);
+    out = put_int<uint64_t>(out, m_timestamp_us);
+    out = put_int<uint32_t>(out, m_period_us);
+    out = put_int<uint8_t>(out, static_cast<uint8_t>(m_count));
+    memcpy(out, m_samples, m_size);
+
+    const size_t frame_size = HEADER_SIZE + m_size;
+    m_count = 0;
+    m_size = 0;
+    return frame_size;
+}
+
+}
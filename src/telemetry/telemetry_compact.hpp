@@ -0,0 +1,111 @@
+#pragma once
+
+#include "telemetry_scheduler.hpp"
+#include "tasks/task_config.hpp"
+#include "state/state_estimator.hpp"
+#include "util/math.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace mp {
+
+// Incremented on every change of the frame or sample layout
+inline constexpr uint8_t TELEMETRY_COMPACT_VERSION = 2;
+
+// Quantization scales, value is sent as round(value * scale)
+inline constexpr float TELEMETRY_COMPACT_POSITION_SCALE = 1000.f;       // int32, mm
+inline constexpr float TELEMETRY_COMPACT_VELOCITY_SCALE = 100.f;        // int16, cm/s
+inline constexpr float TELEMETRY_COMPACT_ACCELERATION_SCALE = 100.f;    // int16, cm/s^2
+inline constexpr float TELEMETRY_COMPACT_ANGULAR_VELOCITY_SCALE = 1000.f; // int16, mrad/s
+
+/**
+ * Batch of samples of a single stream encoded with a fixed layout
+ *
+ * Used for high-rate streams where protobuf encoding of every float costs
+ * too much bandwidth and CPU time. Frame layout (little-endian):
+ *
+ * Header:
+ * - uint8  version (TELEMETRY_COMPACT_VERSION)
+ * - uint8  stream (TelemetryStream)
+ * - uint16 sequence number of the frame for this stream
+ * - uint64 timestamp of the first sample in microseconds, never wraps
+ * - uint32 period between samples in microseconds
+ * - uint8  number of samples
+ *
+ * Followed by the samples:
+ * - ATTITUDE (10 bytes): rotation quaternion packed as smallest-three (uint32),
+ *   angular velocity (3 x int16)
+ * - MOTION (24 bytes): position (3 x int32), velocity (3 x int16),
+ *   acceleration (3 x int16)
+ * - SENSOR_RAW, SENSOR_CORRECTED (12 bytes): accelerometer (3 x int16, same
+ *   scale as acceleration), gyroscope (3 x int16, same scale as angular velocity)
+ *
+ * Smallest-three quaternion packing: bits 31-30 hold the index of the largest
+ * component (w, x, y, z) which is left out, and made positive by negating the
+ * quaternion if needed. The remaining three components, in order, are in range
+ * [-1/sqrt(2), 1/sqrt(2)] and are stored as 10 bit signed values scaled by 511*sqrt(2).
+ */
+class telemetry_compact_batch {
+
+public:
+    static constexpr size_t HEADER_SIZE = 17;
+    static constexpr size_t MAX_SAMPLE_SIZE = 24;
+    static constexpr size_t MAX_SAMPLES = TASK_TELEMETRY_COMPACT_MAX_SAMPLES;
+    static constexpr size_t MAX_FRAME_SIZE = HEADER_SIZE + MAX_SAMPLES * MAX_SAMPLE_SIZE;
+
+    /**
+     * Set the stream of this batch, must be called before use
+     */
+    void set_stream(telemetry_stream_e stream) noexcept
+    {
+        m_stream = stream;
+    }
+
+    /**
+     * Start a new batch, discarding the samples not yet encoded
+     */
+    void start(uint64_t timestamp_us, uint32_t period_us) noexcept;
+
+    size_t get_count() const noexcept
+    {
+        return m_count;
+    }
+
+    uint32_t get_period_us() const noexcept
+    {
+        return m_period_us;
+    }
+
+    bool is_full() const noexcept
+    {
+        return m_count == MAX_SAMPLES;
+    }
+
+    /**
+     * Append a sample of the attitude or motion stream
+     */
+    void append_state(const state_s& state) noexcept;
+
+    /**
+     * Append a sample of the sensor data streams
+     */
+    void append_sensor_data(const vector3f& acc, const vector3f& gyro) noexcept;
+
+    /**
+     * Encode the batch into the frame and empty the batch
+     * @returns Size of the frame
+     */
+    size_t encode_frame(char (&frame)[MAX_FRAME_SIZE]) noexcept;
+
+private:
+    telemetry_stream_e m_stream = mp_pb_TelemetryStream_TELEMETRY_STREAM_ATTITUDE;
+    uint16_t m_sequence = 0;
+    uint64_t m_timestamp_us = 0;
+    uint32_t m_period_us = 0;
+
+    size_t m_count = 0;
+    size_t m_size = 0;
+    uint8_t m_samples[MAX_SAMPLES * MAX_SAMPLE_SIZE];
+};
+
+}
@@ -0,0 +1,82 @@
+#include "telemetry_scheduler.hpp"
+#include <cmath>
+
+namespace mp {
+
+telemetry_scheduler::telemetry_scheduler(tick_period_t tick_period, float default_rate) noexcept :
+    m_tick_rate(1.f / tick_period.count()),
+    m_tick(0)
+{
+    for (size_t stream = 0; stream < STREAM_COUNT; stream++) {
+        m_period[stream] = 0;
+        m_encoding[stream] = mp_pb_TelemetryEncoding_TELEMETRY_ENCODING_PROTOBUF;
+        m_statistics[stream] = false;
+        m_next_due[stream] = 0;
+        subscribe(static_cast<telemetry_stream_e>(stream), default_rate);
+    }
+}
+
+bool telemetry_scheduler::subscribe(
+    telemetry_stream_e stream,
+    float rate,
+    telemetry_encoding_e encoding,
+    bool statistics
+) noexcept
+{
+    if (stream < 0 || stream >= STREAM_COUNT || !(rate >= 0.f))
+        return false;
+    if (encoding < _mp_pb_TelemetryEncoding_MIN || encoding > _mp_pb_TelemetryEncoding_MAX)
+        return false;
+    // Task timing and latency have no compact layout
+    const bool has_compact = stream != mp_pb_TelemetryStream_TELEMETRY_STREAM_TASKS &&
+        stream != mp_pb_TelemetryStream_TELEMETRY_STREAM_LATENCY;
+    if (!has_compact && encoding == mp_pb_TelemetryEncoding_TELEMETRY_ENCODING_COMPACT)
+        return false;
+
+    uint32_t period = 0;
+    if (rate > 0.f) {
+        // Round to the closest whole number of ticks
+        float period_ticks = std::round(m_tick_rate / rate);
+        period = period_ticks < 1.f ? 1 : static_cast<uint32_t>(period_ticks);
+    }
+    m_period[stream].store(period, std::memory_order_relaxed);
+    m_encoding[stream].store(encoding, std::memory_order_relaxed);
+    m_statistics[stream].store(statistics, std::memory_order_relaxed);
+    return true;
+}
+
+size_t telemetry_scheduler::get_due(telemetry_stream_e (&due)[STREAM_COUNT]) const noexcept
+{
+    size_t count = 0;
+
+    for (size_t stream = 0; stream < STREAM_COUNT; stream++) {
+        if (m_period[stream].load(std::memory_order_relaxed) == 0)
+            continue;
+
+        const int32_t lateness = get_lateness(stream);
+        if (lateness < 0)
+            continue;
+
+        // Insertion sort by lateness since there's only a couple of streams
+        size_t i = count++;
+        while (i > 0 && get_lateness(due[i - 1]) < lateness) {
+            due[i] = due[i - 1];
+            i--;
+        }
+        due[i] = static_cast<telemetry_stream_e>(stream);
+    }
+    return count;
+}
+
+void telemetry_scheduler::mark_sent(telemetry_stream_e stream) noexcept
+{
+    const uint32_t period = m_period[stream].load(std::memory_order_relaxed);
+    m_next_due[stream] += period;
+
+    // If the stream fell behind by more than a period (it was deferred
+    // or just subscribed to), don't try to catch up by sending a burst
+    if (get_lateness(stream) >= 0)
+        m_next_due[stream] = m_tick + period;
+}
+
+}
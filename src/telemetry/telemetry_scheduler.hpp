@@ -0,0 +1,117 @@
+#pragma once
+
+#include "pb/telemetry.pb.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace mp {
+
+using telemetry_stream_e = mp_pb_TelemetryStream;
+using telemetry_encoding_e = mp_pb_TelemetryEncoding;
+
+/**
+ * Decides which telemetry streams are due on each tick of the telemetry task
+ *
+ * Each stream has its own period (in ticks) and encoding which can be changed from
+ * any task through `subscribe`, while the rest of the methods must only be called from
+ * the context of the telemetry task. Streams which were due but didn't fit into
+ * the frame stay due, and get a higher priority on the following ticks.
+ */
+class telemetry_scheduler {
+
+public:
+    static constexpr size_t STREAM_COUNT = _mp_pb_TelemetryStream_ARRAYSIZE;
+
+    using tick_period_t = std::chrono::duration<float>;
+
+    explicit telemetry_scheduler(tick_period_t tick_period, float default_rate) noexcept;
+
+    /**
+     * Set the rate of the stream in Hz, or 0 to disable it, its encoding
+     * and whether the field statistics are sent with it
+     * @returns `false` if the stream is not valid or the rate is negative
+     * @note Rates higher than the tick rate are clamped to the tick rate
+     */
+    bool subscribe(
+        telemetry_stream_e stream,
+        float rate,
+        telemetry_encoding_e encoding = mp_pb_TelemetryEncoding_TELEMETRY_ENCODING_PROTOBUF,
+        bool statistics = false
+    ) noexcept;
+
+    /**
+     * Get the current encoding of the stream
+     */
+    telemetry_encoding_e get_encoding(telemetry_stream_e stream) const noexcept
+    {
+        return static_cast<telemetry_encoding_e>(m_encoding[stream].load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Are the field statistics sent with the stream
+     */
+    bool has_statistics(telemetry_stream_e stream) const noexcept
+    {
+        return m_statistics[stream].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the current period of the stream in ticks, 0 if disabled
+     */
+    uint32_t get_period(telemetry_stream_e stream) const noexcept
+    {
+        return m_period[stream].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the number of ticks since the start
+     */
+    uint32_t get_tick() const noexcept
+    {
+        return m_tick;
+    }
+
+    /**
+     * Fill the array with the streams due on the current tick, ordered
+     * so that the most overdue streams are first
+     * @returns Number of due streams
+     */
+    size_t get_due(telemetry_stream_e (&due)[STREAM_COUNT]) const noexcept;
+
+    /**
+     * Mark the stream as sent on the current tick
+     */
+    void mark_sent(telemetry_stream_e stream) noexcept;
+
+    /**
+     * Move on to the next tick
+     */
+    void advance() noexcept
+    {
+        m_tick++;
+    }
+
+private:
+    /**
+     * Number of ticks the stream is late, negative if not due yet
+     */
+    int32_t get_lateness(size_t stream) const noexcept
+    {
+        return static_cast<int32_t>(m_tick - m_next_due[stream]);
+    }
+
+private:
+    const float m_tick_rate;
+    uint32_t m_tick;
+
+    // Written by `subscribe` which can run in any task, 0 if disabled
+    std::atomic<uint32_t> m_period[STREAM_COUNT];
+    std::atomic<uint8_t> m_encoding[STREAM_COUNT];
+    std::atomic<bool> m_statistics[STREAM_COUNT];
+    // Tick on which each stream is next due
+    uint32_t m_next_due[STREAM_COUNT];
+};
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mp {
+
+/**
+ * Write the integer in little-endian byte order, independent of the target
+ * @returns Pointer past the written bytes
+ */
+template <typename int_type>
+inline uint8_t* put_int(uint8_t* out, int_type value) noexcept
+{
+    for (size_t i = 0; i < sizeof(int_type); i++)
+        *out++ = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+    return out;
+}
+
+/**
+ * Read an integer written by `put_int`
+ */
+template <typename int_type>
+inline int_type read_int(const uint8_t* in) noexcept
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(int_type); i++)
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return static_cast<int_type>(value);
+}
+
+}
@@ -0,0 +1,31 @@
+#include "cobs.hpp"
+
+namespace mp {
+
+ssize_t cobs_decode(const uint8_t* in, size_t size, uint8_t* out) noexcept
+{
+    size_t in_index = 0;
+    size_t out_index = 0;
+
+    while (in_index < size) {
+        const uint8_t code = in[in_index++];
+        // Zero can only be the delimiter, and a block can't end past the frame
+        if (code == 0 || in_index + code - 1 > size)
+            return -1;
+
+        // Output never overtakes the input, so this works in place
+        for (uint8_t i = 1; i < code; i++) {
+            const uint8_t byte = in[in_index++];
+            if (byte == 0)
+                return -1;
+            out[out_index++] = byte;
+        }
+
+        // Each block except the last and the full ones ends with a zero
+        if (code != 0xFF && in_index < size)
+            out[out_index++] = 0;
+    }
+    return out_index;
+}
+
+}
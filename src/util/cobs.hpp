@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace mp {
+
+/**
+ * Maximum size of the COBS encoding of data of the given size, without the delimiter
+ */
+constexpr size_t cobs_max_encoded_size(size_t size) noexcept
+{
+    return size + size / 254 + 1;
+}
+
+/**
+ * Decode a COBS encoded frame (without the zero delimiter)
+ * @note Output can be the same buffer as the input, decoding in place
+ * @returns Size of the decoded data or -1 if the frame is not valid
+ */
+ssize_t cobs_decode(const uint8_t* in, size_t size, uint8_t* out) noexcept;
+
+}
@@ -0,0 +1,21 @@
+#include "crc.hpp"
+
+namespace mp {
+
+// CRC of each value of the top nibble, the data is processed 4 bits at a time
+static constexpr uint16_t CRC16_CCITT_NIBBLE_TABLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t crc16_ccitt(const uint8_t* data, size_t size, uint16_t crc) noexcept
+{
+    for (size_t i = 0; i < size; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        crc = (crc << 4) ^ CRC16_CCITT_NIBBLE_TABLE[crc >> 12];
+        crc = (crc << 4) ^ CRC16_CCITT_NIBBLE_TABLE[crc >> 12];
+    }
+    return crc;
+}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mp {
+
+inline constexpr uint16_t CRC16_CCITT_INIT = 0xFFFF;
+
+/**
+ * CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)
+ * @param crc Result of the previous call to continue the calculation
+ */
+uint16_t crc16_ccitt(const uint8_t* data, size_t size, uint16_t crc = CRC16_CCITT_INIT) noexcept;
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace mp {
+
+/**
+ * FNV-1a hash of the string, usable at compile time
+ * @note Also computed by the host tools, so it must not change
+ */
+constexpr uint32_t fnv1a(const char* str) noexcept
+{
+    uint32_t hash = 2166136261u;
+    while (*str) {
+        hash ^= static_cast<uint8_t>(*str++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mp {
+
+/**
+ * Percentiles of the latencies recorded since the previous take
+ * Percentiles are the upper bounds of their buckets, so within 12.5%
+ */
+struct latency_summary_s {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+/**
+ * Log-linear histogram of latencies in microseconds
+ *
+ * Values below 8 have a bucket each, above that every power of 2 is split
+ * into 8 buckets, so the relative error is the same over the whole range
+ * and a value is added in O(1) without any division. Values are added
+ * by a single task and the histogram can be taken from any other task.
+ */
+class latency_histogram {
+
+    static constexpr uint32_t SUB_BUCKET_BITS = 3;
+    static constexpr uint32_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+public:
+    latency_histogram() noexcept :
+        m_counts{},
+        m_max_us(0),
+        m_take_requested(false)
+    {}
+
+    /**
+     * Add a latency
+     * @note Must always be called from the same task
+     */
+    void add(uint32_t latency_us) noexcept
+    {
+        // Window is restarted by the writer so that no bucket is cleared while being incremented
+        if (m_take_requested.load(std::memory_order_acquire)) {
+            for (std::atomic<uint32_t>& count : m_counts)
+                count.store(0, std::memory_order_relaxed);
+            m_max_us.store(0, std::memory_order_relaxed);
+            m_take_requested.store(false, std::memory_order_release);
+        }
+
+        std::atomic<uint32_t>& count = m_counts[get_bucket(latency_us)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (latency_us > m_max_us.load(std::memory_order_relaxed))
+            m_max_us.store(latency_us, std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the percentiles and start a new window with the next added value
+     * @note Can be called from any task
+     */
+    latency_summary_s take() noexcept
+    {
+        latency_summary_s summary {};
+        // Nothing was added since the previous take
+        if (m_take_requested.load(std::memory_order_acquire))
+            return summary;
+
+        // Buckets aren't copied to keep the stack of the reader small, values
+        // added while they're walked can only move a percentile by a bucket
+        for (const std::atomic<uint32_t>& count : m_counts)
+            summary.count += count.load(std::memory_order_relaxed);
+        summary.p50_us = get_percentile(summary.count, 50);
+        summary.p99_us = get_percentile(summary.count, 99);
+        summary.max_us = m_max_us.load(std::memory_order_relaxed);
+        m_take_requested.store(true, std::memory_order_release);
+
+        // Percentiles can't be above the maximum, which is exact
+        summary.p50_us = summary.p50_us < summary.max_us ? summary.p50_us : summary.max_us;
+        summary.p99_us = summary.p99_us < summary.max_us ? summary.p99_us : summary.max_us;
+        return summary;
+    }
+
+private:
+    static size_t get_bucket(uint32_t value) noexcept
+    {
+        if (value < SUB_BUCKET_COUNT)
+            return value;
+        const uint32_t shift = (31 - __builtin_clz(value)) - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKET_COUNT + ((value >> shift) & (SUB_BUCKET_COUNT - 1));
+    }
+
+    /**
+     * Largest value which falls into the bucket
+     */
+    static uint32_t get_bucket_max(size_t bucket) noexcept
+    {
+        if (bucket < SUB_BUCKET_COUNT)
+            return bucket;
+        const uint32_t shift = bucket / SUB_BUCKET_COUNT - 1;
+        const uint64_t min = static_cast<uint64_t>(SUB_BUCKET_COUNT + bucket % SUB_BUCKET_COUNT) << shift;
+        return static_cast<uint32_t>(min + (1ull << shift) - 1);
+    }
+
+    uint32_t get_percentile(uint32_t total, uint32_t percent) const noexcept
+    {
+        // Rank of the value in the sorted latencies, rounded up
+        const uint64_t rank = (static_cast<uint64_t>(total) * percent + 99) / 100;
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            cumulative += m_counts[i].load(std::memory_order_relaxed);
+            if (cumulative >= rank && cumulative > 0)
+                return get_bucket_max(i);
+        }
+        return 0;
+    }
+
+private:
+    std::atomic<uint32_t> m_counts[BUCKET_COUNT];
+    std::atomic<uint32_t> m_max_us;
+    std::atomic<bool> m_take_requested;
+};
+
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "hash.hpp"
+#include "log_ring.hpp"
+#include <emblib/common/logger.hpp>
+#include <emblib/driver/char_dev.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace mp {
+
+// Size byte + message id + level
+inline constexpr size_t LOG_BINARY_HEADER_SIZE = 6;
+// Maximum size of an encoded record including the header
+inline constexpr size_t LOG_BINARY_MAX_RECORD_SIZE = 32;
+
+/**
+ * Id of the log message, FNV-1a hash of the message string
+ * @note Must match the hash used by tools/log_table.py
+ */
+constexpr uint32_t log_message_id(const char* message) noexcept
+{
+    return fnv1a(message);
+}
+
+/**
+ * Type tag written before each argument of a binary record
+ */
+enum log_arg_type_e : uint8_t {
+    LOG_ARG_TYPE_BOOL = 0,
+    LOG_ARG_TYPE_INT8,
+    LOG_ARG_TYPE_UINT8,
+    LOG_ARG_TYPE_INT16,
+    LOG_ARG_TYPE_UINT16,
+    LOG_ARG_TYPE_INT32,
+    LOG_ARG_TYPE_UINT32,
+    LOG_ARG_TYPE_INT64,
+    LOG_ARG_TYPE_UINT64,
+    LOG_ARG_TYPE_FLOAT,
+    LOG_ARG_TYPE_DOUBLE
+};
+
+template <typename arg_type>
+constexpr log_arg_type_e log_arg_type() noexcept
+{
+    using type = std::decay_t<arg_type>;
+    static_assert(std::is_arithmetic_v<type>, "Only arithmetic arguments can be logged in binary");
+
+    if constexpr (std::is_same_v<type, bool>)
+        return LOG_ARG_TYPE_BOOL;
+    else if constexpr (std::is_same_v<type, float>)
+        return LOG_ARG_TYPE_FLOAT;
+    else if constexpr (std::is_floating_point_v<type>)
+        return LOG_ARG_TYPE_DOUBLE;
+    else if constexpr (sizeof(type) == 1)
+        return std::is_signed_v<type> ? LOG_ARG_TYPE_INT8 : LOG_ARG_TYPE_UINT8;
+    else if constexpr (sizeof(type) == 2)
+        return std::is_signed_v<type> ? LOG_ARG_TYPE_INT16 : LOG_ARG_TYPE_UINT16;
+    else if constexpr (sizeof(type) == 4)
+        return std::is_signed_v<type> ? LOG_ARG_TYPE_INT32 : LOG_ARG_TYPE_UINT32;
+    else
+        return std::is_signed_v<type> ? LOG_ARG_TYPE_INT64 : LOG_ARG_TYPE_UINT64;
+}
+
+/**
+ * Logger which sends the message id and the raw argument
+ * bytes instead of the formatted message
+ *
+ * Record layout (little-endian, the same as the target):
+ * - uint8  size of the whole record
+ * - uint32 message id (`log_message_id`)
+ * - uint8  log level
+ * - for every argument: uint8 type tag (`log_arg_type_e`), raw value
+ *
+ * Messages are reconstructed on the host from the table of all the
+ * messages generated by tools/log_table.py. Records are encoded directly
+ * into the log ring if one is set, which is safe from any task or ISR,
+ * otherwise each is written to the output device with a single write.
+ */
+class binary_logger {
+
+public:
+    static binary_logger& get_instance() noexcept;
+
+    void set_output_device(emblib::char_dev& output_device) noexcept
+    {
+        m_output_device.store(&output_device);
+    }
+
+    void set_output_ring(log_ring& ring) noexcept
+    {
+        m_ring.store(&ring);
+    }
+
+    void set_output_level(emblib::log_level_e level) noexcept
+    {
+        m_output_level.store(level);
+    }
+
+    /**
+     * Enable the binary records, only when the output is a framed channel
+     * which keeps them apart from the text log. Disabled by default, in
+     * which case `MP_LOG_*` messages fall back to the text logger
+     */
+    void set_enabled(bool enabled) noexcept
+    {
+        m_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool is_enabled() const noexcept
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Encode the record into the ring or write it to the output device
+     */
+    template <uint32_t message_id, typename ...arg_types>
+    void log(emblib::log_level_e level, arg_types ...args) noexcept
+    {
+        static constexpr size_t RECORD_SIZE = LOG_BINARY_HEADER_SIZE + (0 + ... + (1 + sizeof(arg_types)));
+        static_assert(RECORD_SIZE <= LOG_BINARY_MAX_RECORD_SIZE, "Too many arguments for a binary log record");
+
+        if (level < m_output_level.load())
+            return;
+
+        log_ring* ring = m_ring.load();
+        if (ring) {
+            char* record = ring->reserve(level, LOG_RECORD_BINARY, RECORD_SIZE);
+            if (record) {
+                encode<message_id>(record, level, args...);
+                ring->commit(record);
+            }
+            return;
+        }
+
+        emblib::char_dev* output_device = m_output_device.load();
+        if (output_device) {
+            char record[RECORD_SIZE];
+            encode<message_id>(record, level, args...);
+            output_device->write(record, RECORD_SIZE);
+        }
+    }
+
+private:
+    // Owned by the flight context
+    friend class flight_context;
+
+    binary_logger() = default;
+
+    template <uint32_t message_id, typename ...arg_types>
+    static void encode(char* record, emblib::log_level_e level, arg_types ...args) noexcept
+    {
+        size_t size = 1;
+        size = put(record, size, message_id);
+        record[size++] = static_cast<char>(level);
+        ((record[size++] = static_cast<char>(log_arg_type<arg_types>()), size = put(record, size, args)), ...);
+        record[0] = static_cast<char>(size);
+    }
+
+    template <typename value_type>
+    static size_t put(char* record, size_t offset, value_type value) noexcept
+    {
+        memcpy(record + offset, &value, sizeof(value));
+        return offset + sizeof(value);
+    }
+
+private:
+    std::atomic<emblib::char_dev*> m_output_device {nullptr};
+    std::atomic<log_ring*> m_ring {nullptr};
+    std::atomic<emblib::log_level_e> m_output_level {emblib::log_level_e::DEBUG};
+    std::atomic<bool> m_enabled {false};
+};
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "mpsc_ring.hpp"
+#include <emblib/common/logger.hpp>
+#include <atomic>
+
+namespace mp {
+
+/**
+ * Format of a record in the log ring
+ */
+enum log_record_type_e : uint8_t {
+    LOG_RECORD_TEXT = 0,
+    LOG_RECORD_BINARY
+};
+
+/**
+ * Ring into which the loggers write the messages for the logger task,
+ * counting the messages dropped because the ring was full
+ */
+class log_ring : public mpsc_ring {
+
+public:
+    static constexpr size_t LEVEL_COUNT = 4;
+
+    using mpsc_ring::mpsc_ring;
+
+    /**
+     * Reserve space for a message, counting it as dropped if there is none
+     * @returns Pointer to the message data or nullptr if the ring is full
+     */
+    char* reserve(emblib::log_level_e level, log_record_type_e type, size_t size) noexcept
+    {
+        char* data = mpsc_ring::reserve(size, type);
+        if (!data)
+            m_dropped[static_cast<size_t>(level)].fetch_add(1, std::memory_order_relaxed);
+        return data;
+    }
+
+    /**
+     * Get the number of dropped messages of the level since the previous call
+     */
+    uint32_t take_dropped(emblib::log_level_e level) noexcept
+    {
+        return m_dropped[static_cast<size_t>(level)].exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t> m_dropped[LEVEL_COUNT] {};
+};
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <emblib/common/logger.hpp>
+#include <atomic>
+#include <cstdint>
+
+namespace mp {
+
+/**
+ * Token bucket limiting how often a log message is emitted
+ *
+ * Implemented as the generic cell rate algorithm, so the whole bucket is a
+ * single atomic time stamp and checking it is a short lock-free CAS loop
+ * which is safe from any task or ISR. Occurrences which are not emitted are
+ * counted so that the next emitted one can report them. If the occurrences
+ * stop, the last count is reported by `flush_idle` instead, for which each
+ * throttle links itself into a global list the first time it suppresses one.
+ */
+class log_throttle {
+
+public:
+    /**
+     * @param message Message of the call site, reported with the last suppressed count
+     * @note Constexpr so that the static throttle of a call site needs no guard
+     */
+    constexpr log_throttle(const char* message, emblib::log_level_e level) noexcept :
+        m_message(message),
+        m_level(level)
+    {}
+
+    /**
+     * Check if an occurrence at the given time can be emitted, allowing
+     * `burst` occurrences at once and one per `period_ms` after that
+     * @param suppressed Set to the number of occurrences suppressed since
+     * the last emitted one if this one is emitted
+     * @returns true if this occurrence should be emitted
+     */
+    bool try_emit(uint32_t now_ms, uint32_t period_ms, uint32_t burst, uint32_t& suppressed) noexcept
+    {
+        const uint32_t limit = period_ms * burst;
+        uint32_t tat = m_tat.load(std::memory_order_relaxed);
+        uint32_t new_tat;
+        do {
+            // How far ahead of now the bucket is, it can never legitimately
+            // be more than the limit, so anything else means it is idle (or
+            // the time wrapped around since the last occurrence)
+            uint32_t ahead = tat - now_ms;
+            if (static_cast<int32_t>(ahead) < 0 || ahead > limit)
+                ahead = 0;
+
+            if (ahead + period_ms > limit) {
+                if (m_suppressed.fetch_add(1, std::memory_order_relaxed) == 0)
+                    link();
+                return false;
+            }
+            new_tat = now_ms + ahead + period_ms;
+        } while (!m_tat.compare_exchange_weak(tat, new_tat, std::memory_order_relaxed));
+
+        suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * Take the suppressed counts of the throttles whose occurrences stopped
+     * long enough for the bucket to refill completely
+     * @param callback Called as `callback(level, message, suppressed)`
+     */
+    template <typename callback_type>
+    static void flush_idle(uint32_t now_ms, callback_type&& callback) noexcept
+    {
+        for (log_throttle* throttle = s_head.load(std::memory_order_acquire); throttle; throttle = throttle->m_next) {
+            if (throttle->m_suppressed.load(std::memory_order_relaxed) == 0)
+                continue;
+            if (static_cast<int32_t>(throttle->m_tat.load(std::memory_order_relaxed) - now_ms) > 0)
+                continue;
+
+            // Can race with an emitted occurrence, which then reports 0
+            const uint32_t suppressed = throttle->m_suppressed.exchange(0, std::memory_order_relaxed);
+            if (suppressed > 0)
+                callback(throttle->m_level, throttle->m_message, suppressed);
+        }
+    }
+
+private:
+    /**
+     * Push the throttle to the list once, lock-free so it's safe from ISRs
+     * Throttles are static and are never removed from the list
+     */
+    void link() noexcept
+    {
+        if (m_linked.exchange(true, std::memory_order_relaxed))
+            return;
+        log_throttle* head = s_head.load(std::memory_order_relaxed);
+        do {
+            m_next = head;
+        } while (!s_head.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    static inline std::atomic<log_throttle*> s_head {nullptr};
+
+    const char* m_message;
+    emblib::log_level_e m_level;
+    log_throttle* m_next = nullptr;
+    std::atomic<bool> m_linked {false};
+
+    // Theoretical arrival time of the next occurrence in ms
+    std::atomic<uint32_t> m_tat {0};
+    std::atomic<uint32_t> m_suppressed {0};
+};
+
+}
@@ -1,12 +1,18 @@
 #include "logger.hpp"
+#include "flight_context.hpp"
 #include "pb/log.pb.h"
+#include <cstring>
 
 namespace mp {
 
 logger& logger::get_instance() noexcept
 {
-    static logger s_logger;
-    return s_logger;
+    return flight_context::get_current().get_logger();
+}
+
+binary_logger& binary_logger::get_instance() noexcept
+{
+    return flight_context::get_current().get_binary_logger();
 }
 
 #if MP_LOGGER_USE_PROTOBUF
@@ -49,18 +55,33 @@ void logger::flush(log_level_e level, const buffer_t& buffer, emblib::char_dev&
 {
     // Don't wait if cannot write currently
     static constexpr auto WRITE_TIMEOUT = std::chrono::milliseconds(0);
-
-    // Using the same size for the formatted message as for the protobuf approximately
-    static etl::string<LOGGER_MAX_TOTAL_SIZE> formatted_msg_buffer;
-    
     static const char* level_prefix[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
-    formatted_msg_buffer = level_prefix[static_cast<int>(level)];
-    formatted_msg_buffer += ": ";
-    formatted_msg_buffer += buffer;
-    formatted_msg_buffer += "\n";
+
+    // Format straight into the ring, reserving exactly the space needed
+    log_ring* ring = m_ring.load();
+    if (ring) {
+        const char* prefix = level_prefix[static_cast<int>(level)];
+        const size_t prefix_size = strlen(prefix);
+        const size_t size = prefix_size + 2 + buffer.size() + 1;
+
+        char* data = ring->reserve(level, LOG_RECORD_TEXT, size);
+        if (!data)
+            return;
+        memcpy(data, prefix, prefix_size);
+        memcpy(data + prefix_size, ": ", 2);
+        memcpy(data + prefix_size + 2, buffer.c_str(), buffer.size());
+        data[size - 1] = '\n';
+        ring->commit(data);
+        return;
+    }
+
+    m_formatted_buffer = level_prefix[static_cast<int>(level)];
+    m_formatted_buffer += ": ";
+    m_formatted_buffer += buffer;
+    m_formatted_buffer += "\n";
     
-    log_device.write(formatted_msg_buffer.c_str(), formatted_msg_buffer.size(), WRITE_TIMEOUT);
-    formatted_msg_buffer.clear();
+    log_device.write(m_formatted_buffer.c_str(), m_formatted_buffer.size(), WRITE_TIMEOUT);
+    m_formatted_buffer.clear();
 }
 
 #endif
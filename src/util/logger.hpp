@@ -1,15 +1,59 @@
 #pragma once
 
+#include "log_binary.hpp"
+#include "log_throttle.hpp"
+#include "time.hpp"
+#include "pb/log.pb.h"
 #include <emblib/common/logger.hpp>
+#include <atomic>
+#include <iterator>
 
 #define MP_LOGGER_USE_PROTOBUF      0
+// Send the MP_LOG_* messages as binary records instead of text
+#define MP_LOGGER_BINARY            0
+
+// Lowest level of the MP_LOGS_* messages compiled in, 0 (debug) to 3 (error)
+#ifndef MP_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define MP_LOG_MIN_LEVEL            1
+#else
+#define MP_LOG_MIN_LEVEL            0
+#endif
+#endif
 
 namespace mp {
 
+// Number of occurrences of a throttled message emitted at once
+inline constexpr uint32_t LOG_THROTTLE_BURST = 2;
+
 /**
  * Must match with log.proto log_level enum
  */
 using emblib::log_level_e;
+using log_subsystem_e = mp_pb_Subsystem;
+
+inline constexpr size_t LOG_SUBSYSTEM_COUNT = _mp_pb_Subsystem_ARRAYSIZE;
+inline constexpr log_level_e LOG_MIN_LEVEL = static_cast<log_level_e>(MP_LOG_MIN_LEVEL);
+
+/**
+ * Lowest level compiled in for each subsystem, the messages
+ * below it are removed together with their arguments
+ */
+inline constexpr log_level_e LOG_SUBSYSTEM_MIN_LEVEL[] = {
+    LOG_MIN_LEVEL,  // STATE_EST
+    LOG_MIN_LEVEL,  // ACC
+    LOG_MIN_LEVEL,  // GYRO
+    LOG_MIN_LEVEL,  // RECEIVER
+    LOG_MIN_LEVEL,  // TELEMETRY
+    LOG_MIN_LEVEL,  // VEHICLE
+    LOG_MIN_LEVEL   // IMU
+};
+static_assert(std::size(LOG_SUBSYSTEM_MIN_LEVEL) == LOG_SUBSYSTEM_COUNT, "Every subsystem needs a minimum level");
+
+constexpr bool log_is_compiled(log_subsystem_e subsystem, log_level_e level) noexcept
+{
+    return level >= LOG_SUBSYSTEM_MIN_LEVEL[subsystem];
+}
 
 // Maximum string size in characters (bytes)
 inline constexpr size_t LOGGER_MAX_INPUT_SIZE = 110;
@@ -20,23 +64,68 @@ inline constexpr size_t LOGGER_MAX_TOTAL_SIZE = LOGGER_MAX_INPUT_SIZE + 16;
  * Minipilot logger
  * 
  * Converts messages to a protobuf log message format
- * and sends them to a logging char dev
+ * and sends them to a logging char dev or the log ring
  */
 class logger : public emblib::logger<LOGGER_MAX_INPUT_SIZE> {
 
 public:
     static logger& get_instance() noexcept;
 
+    /**
+     * Format the messages directly into the log ring
+     * instead of writing them to the output device
+     */
+    void set_output_ring(log_ring& ring) noexcept
+    {
+        m_ring.store(&ring);
+    }
+
+    /**
+     * Set which levels are logged for the subsystem,
+     * bit n of the mask enables the level n
+     * @returns false if the subsystem is not valid
+     */
+    bool set_subsystem_mask(log_subsystem_e subsystem, uint8_t level_mask) noexcept
+    {
+        if (subsystem < 0 || subsystem >= LOG_SUBSYSTEM_COUNT)
+            return false;
+        m_subsystem_masks[subsystem].store(level_mask, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * Is the level enabled for the subsystem at runtime
+     */
+    bool is_enabled(log_subsystem_e subsystem, log_level_e level) const noexcept
+    {
+        const uint8_t mask = m_subsystem_masks[subsystem].load(std::memory_order_relaxed);
+        return mask & (1u << static_cast<uint8_t>(level));
+    }
+
 private:
-    // Singleton
-    logger() : emblib::logger<LOGGER_MAX_INPUT_SIZE>(nullptr) {}
+    // Owned by the flight context
+    friend class flight_context;
+
+    logger() : emblib::logger<LOGGER_MAX_INPUT_SIZE>(nullptr)
+    {
+        for (auto& mask : m_subsystem_masks)
+            mask = 0xF;
+    }
 
     void flush(log_level_e level, const buffer_t& buffer, emblib::char_dev& log_device) noexcept override;
+
+private:
+    std::atomic<log_ring*> m_ring {nullptr};
+    // All levels enabled by default
+    std::atomic<uint8_t> m_subsystem_masks[LOG_SUBSYSTEM_COUNT];
+    // Message written to the device before the ring is set, used under the logger lock
+    etl::string<LOGGER_MAX_TOTAL_SIZE> m_formatted_buffer;
 };
 
 static void log_set_level(log_level_e level) noexcept
 {
     logger::get_instance().set_output_level(level);
+    binary_logger::get_instance().set_output_level(level);
 }
 
 template <typename ...item_types>
@@ -63,4 +152,84 @@ static void log_error(item_types&& ...items) noexcept
     logger::get_instance().log(log_level_e::ERROR, items...);
 }
 
-}
\ No newline at end of file
+/**
+ * Log through the binary logger or the text logger, depending on `MP_LOGGER_BINARY`
+ * and on whether the binary logger has a framed output (see `binary_logger::set_enabled`)
+ * Use through the MP_LOG_* macros so that the message id is computed at compile time
+ */
+template <uint32_t message_id, size_t message_size, typename ...arg_types>
+static void log_dispatch(log_level_e level, const char (&message)[message_size], arg_types&& ...args) noexcept
+{
+    if constexpr (MP_LOGGER_BINARY) {
+        binary_logger& binary = binary_logger::get_instance();
+        if (binary.is_enabled()) {
+            binary.log<message_id>(level, args...);
+            return;
+        }
+    }
+    logger::get_instance().log(level, message, args...);
+}
+
+}
+
+#define MP_LOG_MESSAGE(message, ...) message
+
+/**
+ * Log a message which can be sent in binary, the first argument must be a
+ * string literal and the rest are arithmetic values appended to it.
+ * Binary records only take arithmetic arguments, so text can't be put
+ * between the values and a value which needs its own label is logged
+ * in its own message.
+ * These should be used in the time critical code instead of `log_*`.
+ */
+#define MP_LOG(level, ...) \
+    ::mp::log_dispatch<::mp::log_message_id(MP_LOG_MESSAGE(__VA_ARGS__, 0))>(level, __VA_ARGS__)
+
+#define MP_LOG_DEBUG(...)   MP_LOG(::mp::log_level_e::DEBUG, __VA_ARGS__)
+#define MP_LOG_INFO(...)    MP_LOG(::mp::log_level_e::INFO, __VA_ARGS__)
+#define MP_LOG_WARNING(...) MP_LOG(::mp::log_level_e::WARNING, __VA_ARGS__)
+#define MP_LOG_ERROR(...)   MP_LOG(::mp::log_level_e::ERROR, __VA_ARGS__)
+
+/**
+ * Log a message of the subsystem, same as MP_LOG otherwise
+ * Messages below the subsystem's compile-time minimum level are removed
+ * entirely, the rest are filtered by the runtime subsystem mask
+ */
+#define MP_LOGS(subsystem, level, ...) \
+    do { \
+        if constexpr (::mp::log_is_compiled(subsystem, level)) { \
+            if (::mp::logger::get_instance().is_enabled(subsystem, level)) \
+                MP_LOG(level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define MP_LOGS_DEBUG(subsystem, ...)   MP_LOGS(subsystem, ::mp::log_level_e::DEBUG, __VA_ARGS__)
+#define MP_LOGS_INFO(subsystem, ...)    MP_LOGS(subsystem, ::mp::log_level_e::INFO, __VA_ARGS__)
+#define MP_LOGS_WARNING(subsystem, ...) MP_LOGS(subsystem, ::mp::log_level_e::WARNING, __VA_ARGS__)
+#define MP_LOGS_ERROR(subsystem, ...)   MP_LOGS(subsystem, ::mp::log_level_e::ERROR, __VA_ARGS__)
+
+/**
+ * Same as MP_LOGS, but each call site emits at most `LOG_THROTTLE_BURST`
+ * messages at once and then one every `period` (std::chrono duration).
+ * Suppressed occurrences are reported before the next emitted message, or
+ * by the logger task (`log_throttle::flush_idle`) if there is none.
+ * Intended for errors which can repeat on every iteration of a fast loop.
+ */
+#define MP_LOGS_THROTTLED(subsystem, level, period, ...) \
+    do { \
+        if constexpr (::mp::log_is_compiled(subsystem, level)) { \
+            static ::mp::log_throttle s_log_throttle(MP_LOG_MESSAGE(__VA_ARGS__, 0), level); \
+            const uint32_t log_period_ms = std::chrono::duration_cast<std::chrono::milliseconds>(period).count(); \
+            uint32_t log_suppressed = 0; \
+            if (s_log_throttle.try_emit(::mp::get_time_ms(), log_period_ms, ::mp::LOG_THROTTLE_BURST, log_suppressed)) { \
+                if (log_suppressed > 0) \
+                    MP_LOGS(subsystem, level, "Suppressed repeats of the next message: ", log_suppressed); \
+                MP_LOGS(subsystem, level, __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define MP_LOGS_WARNING_THROTTLED(subsystem, period, ...) \
+    MP_LOGS_THROTTLED(subsystem, ::mp::log_level_e::WARNING, period, __VA_ARGS__)
+#define MP_LOGS_ERROR_THROTTLED(subsystem, period, ...) \
+    MP_LOGS_THROTTLED(subsystem, ::mp::log_level_e::ERROR, period, __VA_ARGS__)
@@ -0,0 +1,92 @@
+#include "mpsc_ring.hpp"
+#include <cassert>
+#include <cstring>
+
+namespace mp {
+
+mpsc_ring::mpsc_ring(char* buffer, size_t capacity) noexcept :
+    m_buffer(buffer),
+    m_mask(capacity - 1),
+    m_head(0),
+    m_tail(0)
+{
+    assert((capacity & (capacity - 1)) == 0 && capacity <= HEADER_SIZE_MASK + 1);
+    assert(reinterpret_cast<uintptr_t>(buffer) % HEADER_SIZE == 0);
+
+    // Free space must be zeroed so that no stale header looks committed
+    memset(m_buffer, 0, capacity);
+}
+
+char* mpsc_ring::reserve(size_t size, uint8_t tag) noexcept
+{
+    const uint32_t capacity = m_mask + 1;
+    const uint32_t span = get_record_span(size);
+    if (span > capacity)
+        return nullptr;
+
+    uint32_t head = m_head.load(std::memory_order_relaxed);
+    uint32_t padding;
+    do {
+        // Records don't wrap around, so skip the end of the ring if needed
+        const uint32_t offset = head & m_mask;
+        padding = offset + span > capacity ? capacity - offset : 0;
+
+        const uint32_t tail = m_tail.load(std::memory_order_acquire);
+        if (head + padding + span - tail > capacity)
+            return nullptr;
+    } while (!m_head.compare_exchange_weak(head, head + padding + span, std::memory_order_relaxed));
+
+    if (padding > 0) {
+        header_at(head).store(padding | HEADER_PADDING | HEADER_COMMITTED, std::memory_order_release);
+        head += padding;
+    }
+
+    // Size and tag are set now, the committed flag once the data is written
+    header_at(head).store(static_cast<uint32_t>(size) | (static_cast<uint32_t>(tag) << HEADER_TAG_SHIFT), std::memory_order_relaxed);
+    return m_buffer + (head & m_mask) + HEADER_SIZE;
+}
+
+void mpsc_ring::commit(char* data) noexcept
+{
+    header_t& header = *reinterpret_cast<header_t*>(data - HEADER_SIZE);
+    header.store(header.load(std::memory_order_relaxed) | HEADER_COMMITTED, std::memory_order_release);
+}
+
+bool mpsc_ring::peek(record_s& record) noexcept
+{
+    while (true) {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+            return false;
+
+        const uint32_t header = header_at(tail).load(std::memory_order_acquire);
+        if (!(header & HEADER_COMMITTED))
+            return false;
+
+        if (header & HEADER_PADDING) {
+            release(header & HEADER_SIZE_MASK);
+            continue;
+        }
+
+        record.data = m_buffer + (tail & m_mask) + HEADER_SIZE;
+        record.size = header & HEADER_SIZE_MASK;
+        record.tag = static_cast<uint8_t>(header >> HEADER_TAG_SHIFT);
+        return true;
+    }
+}
+
+void mpsc_ring::pop() noexcept
+{
+    const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    const uint32_t header = header_at(tail).load(std::memory_order_relaxed);
+    release(get_record_span(header & HEADER_SIZE_MASK));
+}
+
+void mpsc_ring::release(uint32_t span) noexcept
+{
+    const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    memset(m_buffer + (tail & m_mask), 0, span);
+    m_tail.store(tail + span, std::memory_order_release);
+}
+
+}
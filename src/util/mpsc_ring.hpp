@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mp {
+
+/**
+ * Lock-free multi-producer single-consumer ring of variable length records
+ *
+ * Producers reserve exactly the space they need with a single CAS, fill it in
+ * place and commit it, so they can run in any task or ISR. The consumer reads
+ * the committed records in the order of reservation directly from the ring and
+ * releases them once it's done with them. A record which is reserved but not yet
+ * committed blocks the consumer until it is committed.
+ *
+ * Each record is prefixed with a 4 byte header and aligned to 4 bytes. A record
+ * never wraps around, the end of the ring is filled with padding instead.
+ */
+class mpsc_ring {
+
+public:
+    struct record_s {
+        char* data;
+        size_t size;
+        uint8_t tag;
+    };
+
+    /**
+     * @param buffer Storage for the ring, aligned to 4 bytes
+     * @param capacity Size of the buffer, power of 2 and at most 64kB
+     */
+    explicit mpsc_ring(char* buffer, size_t capacity) noexcept;
+
+    /**
+     * Reserve space for a record of the given size
+     * @returns Pointer to the record data or nullptr if the ring is full
+     * @note Safe to call from any task or ISR
+     */
+    char* reserve(size_t size, uint8_t tag) noexcept;
+
+    /**
+     * Make the reserved record available to the consumer
+     */
+    void commit(char* data) noexcept;
+
+    /**
+     * Get the oldest record without removing it
+     * @returns false if there are no committed records
+     * @note Consumer only
+     */
+    bool peek(record_s& record) noexcept;
+
+    /**
+     * Remove the record returned by the last `peek`
+     * @note Consumer only
+     */
+    void pop() noexcept;
+
+private:
+    using header_t = std::atomic<uint32_t>;
+
+    static constexpr size_t HEADER_SIZE = sizeof(header_t);
+    static constexpr uint32_t HEADER_SIZE_MASK = 0xFFFF;
+    static constexpr uint32_t HEADER_TAG_SHIFT = 16;
+    static constexpr uint32_t HEADER_COMMITTED = 1u << 24;
+    static constexpr uint32_t HEADER_PADDING = 1u << 25;
+
+    static_assert(header_t::is_always_lock_free, "Ring header must be lock-free");
+    static_assert(sizeof(header_t) == sizeof(uint32_t), "Ring header must be a plain word");
+
+    header_t& header_at(uint32_t position) noexcept
+    {
+        return *reinterpret_cast<header_t*>(m_buffer + (position & m_mask));
+    }
+
+    /**
+     * Space taken in the ring by a record of the given size
+     */
+    static uint32_t get_record_span(size_t size) noexcept
+    {
+        return (HEADER_SIZE + size + 3) & ~3u;
+    }
+
+    /**
+     * Clear the space taken by the record at the tail and move the tail past it
+     */
+    void release(uint32_t span) noexcept;
+
+private:
+    char* const m_buffer;
+    const uint32_t m_mask;
+
+    // Free running positions, only their lower bits are used as offsets
+    std::atomic<uint32_t> m_head;
+    std::atomic<uint32_t> m_tail;
+};
+
+}
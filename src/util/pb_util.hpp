@@ -1,7 +1,11 @@
 #pragma once
 
 #include "util/math.hpp"
+#include "util/running_stats.hpp"
+#include "params/param_store.hpp"
 #include "pb/types.pb.h"
+#include "pb/param.pb.h"
+#include <cstring>
 
 namespace mp {
 
@@ -19,5 +23,46 @@ inline void pb_vector4f_set(mp_pb_Vector4f& pb_vec, const vector4f& mp_vec)
     pb_vec.y = mp_vec(2);
     pb_vec.z = mp_vec(3);
 }
-    
-}
\ No newline at end of file
+
+inline void pb_vector3f_stats_set(mp_pb_Vector3fStats& pb_stats, const running_stats3f& mp_stats)
+{
+    pb_vector3f_set(pb_stats.min, mp_stats.get_min());
+    pb_vector3f_set(pb_stats.max, mp_stats.get_max());
+    pb_vector3f_set(pb_stats.mean, mp_stats.get_mean());
+    pb_vector3f_set(pb_stats.rms, mp_stats.get_rms());
+    // Without samples only the zero count is sent, min and max would be the
+    // initial sentinels
+    const bool has_samples = mp_stats.get_count() > 0;
+    pb_stats.has_min = has_samples;
+    pb_stats.has_max = has_samples;
+    pb_stats.has_mean = has_samples;
+    pb_stats.has_rms = has_samples;
+    pb_stats.count = mp_stats.get_count();
+}
+
+inline void pb_param_value_set(mp_pb_ParamValue& pb_value, param_id_e id)
+{
+    const param_def_s& def = PARAM_DEFS[id];
+    const param_store& params = param_store::get_instance();
+
+    pb_value.id = def.hash;
+    strncpy(pb_value.name, def.name, sizeof(pb_value.name) - 1);
+    pb_value.name[sizeof(pb_value.name) - 1] = '\0';
+    pb_value.type = def.type;
+    switch (def.type) {
+    case mp_pb_ParamType_PARAM_TYPE_FLOAT:
+        pb_value.which_value = mp_pb_ParamValue_float_value_tag;
+        pb_value.value.float_value = params.get_float(id);
+        break;
+    case mp_pb_ParamType_PARAM_TYPE_INT32:
+        pb_value.which_value = mp_pb_ParamValue_int_value_tag;
+        pb_value.value.int_value = params.get_int(id);
+        break;
+    default:
+        pb_value.which_value = mp_pb_ParamValue_bool_value_tag;
+        pb_value.value.bool_value = params.get_bool(id);
+        break;
+    }
+}
+
+}
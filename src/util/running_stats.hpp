@@ -0,0 +1,128 @@
+#pragma once
+
+#include "util/math.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace mp {
+
+/**
+ * Per-component min, max, mean and RMS of a vector
+ * over the samples added since the last reset
+ *
+ * Each sample is added in O(1), only the sums are kept and the
+ * mean and RMS are computed on demand. The accumulator isn't
+ * synchronized, so the owner should add to it and take it under
+ * the same lock which protects the sampled value.
+ */
+template <typename scalar_type, size_t size>
+class running_stats {
+
+public:
+    using vector_t = vector<scalar_type, size>;
+
+    running_stats() noexcept
+    {
+        reset();
+    }
+
+    /**
+     * Add a sample to the statistics
+     */
+    void add(const vector_t& sample) noexcept
+    {
+        for (size_t i = 0; i < size; i++) {
+            const scalar_type value = sample(i);
+            m_min(i) = value < m_min(i) ? value : m_min(i);
+            m_max(i) = value > m_max(i) ? value : m_max(i);
+            m_sum(i) += value;
+            m_sum_sq(i) += value * value;
+        }
+        m_count++;
+    }
+
+    /**
+     * Discard all the samples
+     */
+    void reset() noexcept
+    {
+        for (size_t i = 0; i < size; i++) {
+            m_min(i) = std::numeric_limits<scalar_type>::max();
+            m_max(i) = std::numeric_limits<scalar_type>::lowest();
+            m_sum(i) = 0;
+            m_sum_sq(i) = 0;
+        }
+        m_count = 0;
+    }
+
+    /**
+     * Add the samples of other statistics to these
+     */
+    void merge(const running_stats& other) noexcept
+    {
+        for (size_t i = 0; i < size; i++) {
+            m_min(i) = other.m_min(i) < m_min(i) ? other.m_min(i) : m_min(i);
+            m_max(i) = other.m_max(i) > m_max(i) ? other.m_max(i) : m_max(i);
+            m_sum(i) += other.m_sum(i);
+            m_sum_sq(i) += other.m_sum_sq(i);
+        }
+        m_count += other.m_count;
+    }
+
+    /**
+     * Get a copy of the statistics and reset them in a single step
+     */
+    running_stats take() noexcept
+    {
+        running_stats stats = *this;
+        reset();
+        return stats;
+    }
+
+    uint32_t get_count() const noexcept
+    {
+        return m_count;
+    }
+
+    /**
+     * @note Min and max are only valid if there is at least one sample
+     */
+    const vector_t& get_min() const noexcept
+    {
+        return m_min;
+    }
+
+    const vector_t& get_max() const noexcept
+    {
+        return m_max;
+    }
+
+    vector_t get_mean() const noexcept
+    {
+        vector_t mean;
+        for (size_t i = 0; i < size; i++)
+            mean(i) = m_count > 0 ? m_sum(i) / m_count : 0;
+        return mean;
+    }
+
+    vector_t get_rms() const noexcept
+    {
+        vector_t rms;
+        for (size_t i = 0; i < size; i++)
+            rms(i) = m_count > 0 ? std::sqrt(m_sum_sq(i) / m_count) : 0;
+        return rms;
+    }
+
+private:
+    vector_t m_min;
+    vector_t m_max;
+    vector_t m_sum;
+    vector_t m_sum_sq;
+    uint32_t m_count;
+};
+
+using running_stats3f = running_stats<float, 3>;
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace mp {
+
+/**
+ * Latest value slot with a single writer and any number of readers
+ *
+ * The writer never waits, and a reader retries the copy if the value was
+ * being written at the same time, so neither can block the other. Used to
+ * publish values where only the newest one matters, such as the stick input.
+ */
+template <typename value_type>
+class seqlock {
+
+    static_assert(std::is_trivially_copyable_v<value_type>, "Seqlock value is copied while it can be written");
+
+public:
+    /**
+     * Publish a new value
+     * @note Only a single task (or ISR) may write
+     */
+    void write(const value_type& value) noexcept
+    {
+        const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        // Odd sequence marks a write in progress
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_value = value;
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * Copy the latest value
+     * @returns false if nothing was written yet
+     */
+    bool read(value_type& value) const noexcept
+    {
+        uint32_t sequence_before;
+        uint32_t sequence_after;
+        do {
+            sequence_before = m_sequence.load(std::memory_order_acquire);
+            value = m_value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            sequence_after = m_sequence.load(std::memory_order_relaxed);
+        } while (sequence_before != sequence_after || (sequence_before & 1));
+
+        return sequence_before != 0;
+    }
+
+private:
+    std::atomic<uint32_t> m_sequence {0};
+    value_type m_value {};
+};
+
+}
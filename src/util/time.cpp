@@ -0,0 +1,34 @@
+#include "time.hpp"
+#include <atomic>
+#include <chrono>
+
+namespace mp {
+
+static std::atomic<time_source_t> g_time_source {nullptr};
+
+void set_time_source(time_source_t time_source) noexcept
+{
+    g_time_source.store(time_source);
+}
+
+uint64_t get_time_us() noexcept
+{
+    time_source_t time_source = g_time_source.load(std::memory_order_relaxed);
+    if (time_source)
+        return time_source();
+
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+uint64_t get_time_ns() noexcept
+{
+    time_source_t time_source = g_time_source.load(std::memory_order_relaxed);
+    if (time_source)
+        return time_source() * 1000;
+
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+}
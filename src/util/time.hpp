@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+namespace mp {
+
+/**
+ * Function returning a monotonic time in microseconds
+ */
+using time_source_t = uint64_t (*)();
+
+/**
+ * Set the source of the time returned by `get_time_us`
+ * @note If not set, `std::chrono::steady_clock` is used
+ */
+void set_time_source(time_source_t time_source) noexcept;
+
+/**
+ * Monotonic time in microseconds
+ */
+uint64_t get_time_us() noexcept;
+
+/**
+ * Monotonic time in nanoseconds, with the resolution
+ * of the time source if one is set
+ */
+uint64_t get_time_ns() noexcept;
+
+/**
+ * Monotonic time in milliseconds, wraps around every ~49 days
+ */
+inline uint32_t get_time_ms() noexcept
+{
+    return static_cast<uint32_t>(get_time_us() / 1000);
+}
+
+}
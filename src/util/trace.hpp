@@ -0,0 +1,134 @@
+#pragma once
+
+#include "time.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Record the MP_TRACE_SCOPE events, otherwise the macros compile out
+#ifndef MP_TRACE
+#define MP_TRACE                    0
+#endif
+
+#define MP_TRACE_CONCAT_(a, b) a##b
+#define MP_TRACE_CONCAT(a, b) MP_TRACE_CONCAT_(a, b)
+
+#if MP_TRACE
+/**
+ * Record the time spent in the rest of the enclosing scope as a trace event
+ * @param name String literal, only the pointer is stored
+ */
+#define MP_TRACE_SCOPE(name) const ::mp::trace_scope MP_TRACE_CONCAT(mp_trace_scope_, __LINE__) {name}
+#else
+#define MP_TRACE_SCOPE(name) ((void)0)
+#endif
+
+namespace mp {
+
+// Number of events kept per task, the oldest ones are overwritten
+inline constexpr size_t TRACE_RING_SIZE = 2048;
+
+struct trace_event_s {
+    const char* name;
+    uint64_t begin_ns;
+    uint32_t duration_ns;
+};
+
+/**
+ * Flight recorder of the trace events of a single task
+ *
+ * Only the owning task writes, so recording an event is a plain store
+ * and an index increment. The ring is read once the tasks are stopped,
+ * at the end of a host run, so the reader doesn't synchronize with the
+ * writer beyond the index.
+ */
+class trace_ring {
+
+    static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "Trace ring size must be a power of 2");
+
+public:
+    void push(const char* name, uint64_t begin_ns, uint64_t end_ns) noexcept
+    {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        m_events[head & (TRACE_RING_SIZE - 1)] = {name, begin_ns, static_cast<uint32_t>(end_ns - begin_ns)};
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * Number of events which can be read, at most the size of the ring
+     */
+    size_t get_count() const noexcept
+    {
+        const uint32_t head = m_head.load(std::memory_order_acquire);
+        return head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+    }
+
+    /**
+     * Get the event by its age, 0 being the oldest one kept
+     */
+    const trace_event_s& get_event(size_t index) const noexcept
+    {
+        const uint32_t head = m_head.load(std::memory_order_acquire);
+        return m_events[(head - get_count() + index) & (TRACE_RING_SIZE - 1)];
+    }
+
+    /**
+     * Make this the ring of the calling thread, where its scopes are recorded
+     * @note The trace scopes rely on `thread_local`, so tracing is meant for host builds,
+     * or schedulers which switch `get_current_storage` with the task
+     */
+    void set_current() noexcept
+    {
+        s_current = this;
+    }
+
+    static trace_ring* get_current() noexcept
+    {
+        return s_current;
+    }
+
+    /**
+     * Storage of the current ring pointer, for schedulers which run
+     * multiple tasks on one thread and have to switch it with the task
+     */
+    static trace_ring** get_current_storage() noexcept
+    {
+        return &s_current;
+    }
+
+private:
+    trace_event_s m_events[TRACE_RING_SIZE];
+    std::atomic<uint32_t> m_head {0};
+
+    inline static thread_local trace_ring* s_current = nullptr;
+};
+
+/**
+ * Guard recording its lifetime into the ring of the current thread,
+ * threads without a ring don't record anything
+ */
+class trace_scope {
+
+public:
+    explicit trace_scope(const char* name) noexcept :
+        m_name(name),
+        m_ring(trace_ring::get_current()),
+        m_begin_ns(m_ring ? get_time_ns() : 0)
+    {}
+
+    ~trace_scope() noexcept
+    {
+        if (m_ring)
+            m_ring->push(m_name, m_begin_ns, get_time_ns());
+    }
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+private:
+    const char* m_name;
+    trace_ring* m_ring;
+    uint64_t m_begin_ns;
+};
+
+}
@@ -6,10 +6,49 @@ namespace mp {
 
 copter_controller_pid::copter_controller_pid(const copter_params_s& copter_params) noexcept :
     m_copter_params(copter_params),
-    m_angular_velocity_pid(1, 0.2, 0),
-    m_linear_acceleration_pid(1, 2, 0),
+    m_angular_velocity_pid(
+        param_store::get_instance().get<PARAM_CTRL_W_P>(),
+        param_store::get_instance().get<PARAM_CTRL_W_I>(),
+        param_store::get_instance().get<PARAM_CTRL_W_D>()
+    ),
+    m_linear_acceleration_pid(
+        param_store::get_instance().get<PARAM_CTRL_V_P>(),
+        param_store::get_instance().get<PARAM_CTRL_V_I>(),
+        param_store::get_instance().get<PARAM_CTRL_V_D>()
+    ),
     m_control_mode(control_mode_e::ANGULAR)
-{}
+{
+    param_store& params = param_store::get_instance();
+    for (param_id_e id : {PARAM_CTRL_W_P, PARAM_CTRL_W_I, PARAM_CTRL_W_D, PARAM_CTRL_V_P, PARAM_CTRL_V_I, PARAM_CTRL_V_D})
+        params.set_listener(id, this);
+}
+
+void copter_controller_pid::param_changed(param_id_e id) noexcept
+{
+    const param_store& params = param_store::get_instance();
+    switch (id) {
+    case PARAM_CTRL_W_P:
+    case PARAM_CTRL_W_I:
+    case PARAM_CTRL_W_D:
+        m_angular_velocity_pid = emblib::pid<vector3f, float>(
+            params.get<PARAM_CTRL_W_P>(),
+            params.get<PARAM_CTRL_W_I>(),
+            params.get<PARAM_CTRL_W_D>()
+        );
+        break;
+    case PARAM_CTRL_V_P:
+    case PARAM_CTRL_V_I:
+    case PARAM_CTRL_V_D:
+        m_linear_acceleration_pid = emblib::pid<vector3f, float>(
+            params.get<PARAM_CTRL_V_P>(),
+            params.get<PARAM_CTRL_V_I>(),
+            params.get<PARAM_CTRL_V_D>()
+        );
+        break;
+    default:
+        break;
+    }
+}
 
 bool copter_controller_pid::set_target_w(const vector3f& target_w, float target_thrust) noexcept
 {
@@ -2,11 +2,16 @@
 
 #include "copter_controller.hpp"
 #include "vehicles/copter/copter.hpp"
+#include "params/param_store.hpp"
 #include <emblib/dsp/pid.hpp>
 
 namespace mp {
 
-class copter_controller_pid : public copter_controller {
+/**
+ * Cascaded PID control of the angular velocity, and optionally the linear velocity
+ * @note Gains are the ctrl.* parameters, changing them resets the integrators
+ */
+class copter_controller_pid : public copter_controller, public param_listener {
 
 enum class control_mode_e {
     ANGULAR,
@@ -21,6 +26,11 @@ public:
     bool set_target_v(const vector3f& target_v, float target_dir) noexcept override;
     
     void update(const state_s& state, float dt) noexcept override;
+
+    /**
+     * Rebuild the PID whose gain changed
+     */
+    void param_changed(param_id_e id) noexcept override;
     
     vector3f get_torque() const noexcept override
     {
@@ -1,6 +1,8 @@
 #include "copter.hpp"
+#include "params/param_store.hpp"
 #include "util/constants.hpp"
 #include "util/logger.hpp"
+#include "util/trace.hpp"
 
 namespace mp {
 
@@ -17,7 +19,14 @@ vector3f copter::get_linear_acceleration(
     // minimize any velocity generated by the state estimator
     if (m_grounded)
         return -COPTER_FRICTION_COEFF / m_params.mass * v;
-        
+    return get_flight_linear_acceleration(v, q);
+}
+
+vector3f copter::get_flight_linear_acceleration(
+    const vector3f& v,
+    const quaternionf& q
+) const noexcept
+{
     const vector3f thrust_force = get_thrust() * q.rotate_vec(UP);
     const vector3f drag_force = -m_params.lin_drag_c * v;
 
@@ -32,7 +41,15 @@ vector3f copter::get_angular_acceleration(
 {
     if (m_grounded)
         return vector3f(0);
+    return get_flight_angular_acceleration(v, w, q);
+}
 
+vector3f copter::get_flight_angular_acceleration(
+    const vector3f& v,
+    const vector3f& w,
+    const quaternionf& q
+) const noexcept
+{
     const matrix3f& I = m_params.moment_of_inertia;
     const vector3f I_w = I.matmul(w);
 
@@ -92,10 +109,10 @@ void copter::update_grounded(const state_s& state) noexcept
     if (m_grounded) {
         if (state.acceleration.dot(UP) > TAKEOFF_ACCELERATION_THRESHOLD) {
             m_grounded = false;
-            log_info("Copter takeoff!");
+            MP_LOGS_INFO(mp_pb_Subsystem_SUBSYSTEM_VEHICLE, "Copter takeoff!");
             float mass = get_thrust() / G;
             // TODO: Assign copter mass to m_params
-            log_info("Calculated copter mass: ", mass);
+            MP_LOGS_INFO(mp_pb_Subsystem_SUBSYSTEM_VEHICLE, "Calculated copter mass: ", mass);
         }
     } else {
         bool stationary = state.velocity.norm_sq() < STATIONARY_SPEED_SQ_THRESHOLD;
@@ -118,8 +135,14 @@ void copter::update(const state_s& state, float dt) noexcept
 {
     update_grounded(state);
     
-    m_controller.update(state, dt);
-    actuate(m_controller.get_thrust(), m_controller.get_torque());
+    {
+        MP_TRACE_SCOPE("controller");
+        m_controller.update(state, dt);
+    }
+
+    MP_TRACE_SCOPE("actuate");
+    // Controller output is computed from the state, so it's as old as the state
+    actuate(m_controller.get_thrust(), m_controller.get_torque(), state.timestamp_us);
 }
 
 bool copter::handle_command(const mp_pb_Command& command) noexcept
@@ -151,4 +174,19 @@ bool copter::handle_command(const mp_pb_Command& command) noexcept
     return command_status;
 }
 
-}
\ No newline at end of file
+bool copter::handle_rc_input(const rc_input_s& input) noexcept
+{
+    const float roll = input.channels[0];
+    const float pitch = input.channels[1];
+    // Throttle stick goes from -1 (idle) to 1 (full)
+    const float throttle = 0.5f * (input.channels[2] + 1.f);
+    const float yaw = input.channels[3];
+
+    // Angular velocity at full stick deflection and thrust at full throttle relative to the weight
+    const param_store& params = param_store::get_instance();
+    const vector3f target_w = params.get<PARAM_RC_MAX_RATE>() * (roll * FORWARD + pitch * LEFT + yaw * UP);
+    const float target_thrust = throttle * params.get<PARAM_RC_MAX_THRUST_RATIO>() * m_params.mass * G;
+    return m_controller.set_target_w(target_w, target_thrust);
+}
+
+}
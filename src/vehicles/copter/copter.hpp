@@ -41,6 +41,12 @@ public:
      */
     bool handle_command(const mp_pb_Command& command) noexcept override;
 
+    /**
+     * Set the target angular velocity and thrust from the sticks
+     * Channels are: roll rate, pitch rate, throttle, yaw rate
+     */
+    bool handle_rc_input(const rc_input_s& input) noexcept override;
+
     /**
      * Returns the acceleration of the model in the global coordinate frame
      * assuming that thrust is produced in the model::UP direction
@@ -59,6 +65,24 @@ public:
         const quaternionf& q
     ) const noexcept override;
 
+    /**
+     * Linear acceleration in flight, from the thrust and the drag
+     * @note Used by the host simulation as the model of the real copter
+     */
+    vector3f get_flight_linear_acceleration(
+        const vector3f& v,
+        const quaternionf& q
+    ) const noexcept;
+
+    /**
+     * Angular acceleration in flight, from the torque and the Euler's equations
+     */
+    vector3f get_flight_angular_acceleration(
+        const vector3f& v,
+        const vector3f& w,
+        const quaternionf& q
+    ) const noexcept;
+
     /**
      * 
      */
@@ -72,8 +96,10 @@ private:
     /**
      * This method should convert the given thrust and torque values
      * into motor speeds and write those parameters to the motors
+     * @param timestamp_us Acquisition time of the data behind the controller
+     * output, passed to `record_actuation` once the motors are written
      */
-    virtual void actuate(float thrust, const vector3f& torque) noexcept = 0;
+    virtual void actuate(float thrust, const vector3f& torque, uint64_t timestamp_us) noexcept = 0;
 
     /**
      * Copter implementation should return the currently produced thrust
@@ -4,7 +4,7 @@
 
 namespace mp {
 
-void quadcopter::actuate(float thrust, const vector3f& torque) noexcept
+void quadcopter::actuate(float thrust, const vector3f& torque, uint64_t timestamp_us) noexcept
 {
     motor_speeds_s required_speeds = inverse_mma(thrust, torque);
 
@@ -14,6 +14,7 @@ void quadcopter::actuate(float thrust, const vector3f& torque) noexcept
     m_actuators.fr.write_throttle(required_speeds.fr);
     m_actuators.bl.write_throttle(required_speeds.bl);
     m_actuators.br.write_throttle(required_speeds.br);
+    record_actuation(timestamp_us);
 }
 
 quadcopter::motor_speeds_s quadcopter::read_motor_speeds(bool square) const noexcept
@@ -37,7 +37,7 @@ private:
     /**
      * Computes the needed speeds via inverse_mma and assigns them to the appropriate motors
      */
-    void actuate(float thrust, const vector3f& torque) noexcept override;
+    void actuate(float thrust, const vector3f& torque, uint64_t timestamp_us) noexcept override;
 
     /**
      * Compute the thrust based on current motor speeds
@@ -1,11 +1,31 @@
 #pragma once
 
 #include "state/state_estimator.hpp"
+#include "util/latency_histogram.hpp"
+#include "util/logger.hpp"
 #include "util/math.hpp"
+#include "util/time.hpp"
 #include "pb/command.pb.h"
+#include <cstddef>
+#include <cstdint>
 
 namespace mp {
 
+// Number of channels in the stick input frame
+inline constexpr size_t RC_CHANNEL_COUNT = 8;
+
+/**
+ * Stick input from the remote controller
+ *
+ * Channels are normalized to [-1, 1], and their meaning is vehicle specific.
+ * Sequence number is incremented by the sender for every frame, so
+ * the same input is not applied twice.
+ */
+struct rc_input_s {
+    uint16_t sequence;
+    float channels[RC_CHANNEL_COUNT];
+};
+
 /**
  * Base class for all vehicles
  * 
@@ -31,6 +51,54 @@ public:
      */
     virtual bool handle_command(const mp_pb_Command& command) noexcept = 0;
 
+    /**
+     * Apply the latest stick input, called before `update`
+     * when new input is available
+     * @returns false if the vehicle doesn't support stick input
+     */
+    virtual bool handle_rc_input(const rc_input_s& input) noexcept
+    {
+        UNUSED(input);
+        return false;
+    }
+
+    /**
+     * Get the age of the sensor data behind the actuator writes since the previous call
+     * @note Can be called from any task
+     */
+    latency_summary_s take_actuation_latency() noexcept
+    {
+        return m_actuation_latency.take();
+    }
+
+    /**
+     * Log the actuation latency, used as a summary at the end of host runs
+     */
+    void log_latency_report() noexcept
+    {
+        const latency_summary_s latency = take_actuation_latency();
+        log_info(
+            "Actuation latency: samples ", latency.count, ", p50 ", latency.p50_us,
+            "us, p99 ", latency.p99_us, "us, max ", latency.max_us, "us"
+        );
+    }
+
+protected:
+    /**
+     * Record that the actuators were written with the output computed
+     * from the sensor data acquired at the given time
+     * @note Should be called by the vehicle right after the actuator writes
+     */
+    void record_actuation(uint64_t timestamp_us) noexcept
+    {
+        // States before the first sensor sample have no timestamp
+        if (timestamp_us == 0)
+            return;
+        const uint64_t now_us = get_time_us();
+        m_actuation_latency.add(now_us > timestamp_us ? static_cast<uint32_t>(now_us - timestamp_us) : 0);
+    }
+
+public:
     /**
      * Get information about onboard sensors
      * @note Should provide a list of all available sensors and a task
@@ -44,6 +112,8 @@ public:
     /// where coords are provided by the state estimator task based on both
     /// gps data but also corrected using the ins velocity integration
 
+private:
+    latency_histogram m_actuation_latency;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+"""
+Measures the round-trip latency of the commands sent to the minipilot
+
+Sends a harmless command (enabling all the log levels of the telemetry
+subsystem, which is the default) at the given rate with an increasing
+sequence number and the send time, and matches the acknowledgments read
+from the output device. Reports the distribution of
+the round-trip time and of the time the command spent on board between
+being received and applied.
+
+Usage: python3 tools/command_latency.py <receiver device> <output device> [--count N] [--rate Hz]
+Devices are opened as plain files, so serial ports must be configured beforehand
+"""
+
+import argparse
+import os
+import sys
+import threading
+import time
+
+import mp_frames
+from mp_frames import frame_pb2
+
+import command_pb2
+import log_pb2
+
+
+def now_us():
+    return time.monotonic_ns() // 1000
+
+
+def percentiles(values, points=(50, 90, 99, 100)):
+    values = sorted(values)
+    return {p: values[min(len(values) - 1, (len(values) * p) // 100)] for p in points}
+
+
+def print_distribution(name, values_us):
+    if not values_us:
+        print(f"{name}: no samples")
+        return
+    summary = ", ".join(f"p{p} {v / 1000:.2f}ms" for p, v in percentiles(values_us).items())
+    print(f"{name} ({len(values_us)} samples): {summary}")
+
+
+def send_commands(device, count, rate):
+    for sequence in range(1, count + 1):
+        command = command_pb2.Command()
+        command.sequence = sequence
+        command.send_time = now_us() & 0xFFFFFFFF
+        command.log_set_mask.subsystem = log_pb2.SUBSYSTEM_TELEMETRY
+        command.log_set_mask.level_mask = 0xF
+        device.write(mp_frames.encode_receiver_frame(
+            frame_pb2.RECEIVER_FRAME_TYPE_COMMAND, command.SerializeToString()))
+        time.sleep(1.0 / rate)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("receiver", help="Device connected to the minipilot receiver")
+    parser.add_argument("output", help="Device connected to the minipilot output")
+    parser.add_argument("--count", type=int, default=100)
+    parser.add_argument("--rate", type=float, default=10.0, help="Commands per second")
+    args = parser.parse_args()
+
+    receiver = open(args.receiver, "wb", buffering=0)
+    output = open(args.output, "rb", buffering=0)
+
+    sender = threading.Thread(target=send_commands, args=(receiver, args.count, args.rate), daemon=True)
+    sender.start()
+
+    round_trip = []
+    on_board = []
+    failed = 0
+    # Give the last acks one second to arrive
+    deadline = time.monotonic() + args.count / args.rate + 1.0
+    # Polled so that the deadline is also checked when the link is silent
+    for frame_type, payload in mp_frames.read_frames(output, poll_interval=0.1):
+        if frame_type == frame_pb2.FRAME_TYPE_ACK:
+            for sequence, send_time, receive_time, apply_time, result in mp_frames.decode_acks(payload):
+                round_trip.append((now_us() - send_time) & 0xFFFFFFFF)
+                on_board.append((apply_time - receive_time) & 0xFFFFFFFF)
+                failed += result != command_pb2.COMMAND_RESULT_OK
+        if len(round_trip) == args.count or time.monotonic() > deadline:
+            break
+
+    print(f"Acknowledged {len(round_trip)}/{args.count} commands, {failed} failed")
+    print_distribution("Round trip", round_trip)
+    print_distribution("Received to applied", on_board)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+"""
+Generates the table of the binary log messages used to reconstruct the
+text of the binary log records on the host
+
+Finds all the MP_LOG_* and MP_LOGS_* calls in the sources and writes a JSON object
+mapping the message id (see src/util/log_binary.hpp) to the message and
+its location.
+
+Usage: python3 tools/log_table.py <output file> <source dir>...
+"""
+
+import codecs
+import json
+import os
+import re
+import sys
+
+# Message is the first string literal in the arguments of the call
+LOG_CALL = re.compile(r'MP_LOGS?(?:_DEBUG|_INFO|_WARNING|_ERROR)?(?:_THROTTLED)?\s*\([^";\n]*?"((?:[^"\\]|\\.)*)"')
+SOURCE_EXTENSIONS = (".cpp", ".hpp", ".h", ".c")
+
+
+def log_message_id(message):
+    """
+    FNV-1a hash, must match `log_message_id` in src/util/log_binary.hpp
+    """
+    value = 2166136261
+    for byte in message.encode():
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def find_messages(source_dir):
+    for root, _, files in os.walk(source_dir):
+        for name in sorted(files):
+            if not name.endswith(SOURCE_EXTENSIONS):
+                continue
+            path = os.path.join(root, name)
+            with open(path, encoding="utf-8") as source:
+                text = source.read()
+            for match in LOG_CALL.finditer(text):
+                message = codecs.decode(match.group(1), "unicode_escape")
+                line = text.count("\n", 0, match.start()) + 1
+                yield message, f"{os.path.relpath(path)}:{line}"
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__)
+        sys.exit(1)
+
+    table = {}
+    for source_dir in sys.argv[2:]:
+        for message, location in find_messages(source_dir):
+            message_id = log_message_id(message)
+            entry = table.setdefault(message_id, {"message": message, "locations": []})
+            if entry["message"] != message:
+                sys.exit(f"Log message id collision: '{message}' ({location}) and '{entry['message']}'")
+            entry["locations"].append(location)
+
+    with open(sys.argv[1], "w") as output:
+        json.dump({str(k): v for k, v in sorted(table.items())}, output, indent=2)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,230 @@
+"""
+Parsing of the frames sent by the minipilot transmitter task
+
+Frame layout is described in protobuf/src/frame.proto and the compact
+telemetry layout in src/telemetry/telemetry_compact.hpp
+"""
+
+import json
+import math
+import os
+import select
+import struct
+import sys
+
+# Generated protobuf python files
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "protobuf", "out", "py"))
+
+import frame_pb2
+import telemetry_pb2
+
+FRAME_SYNC = 0xA5
+COBS_DELIMITER = b"\x00"
+FRAME_HEADER = struct.Struct("<BBH")
+
+ACK_RECORD = struct.Struct("<IIIIB")
+
+LOG_LEVELS = ("DEBUG", "INFO", "WARNING", "ERROR")
+LOG_BINARY_HEADER = struct.Struct("<BIB")
+# Struct format of each log_arg_type_e tag
+LOG_ARG_FORMATS = ("?", "b", "B", "h", "H", "i", "I", "q", "Q", "f", "d")
+
+TELEMETRY_COMPACT_VERSION = 2
+TELEMETRY_COMPACT_HEADER = struct.Struct("<BBHQIB")
+
+POSITION_SCALE = 1000.0
+VELOCITY_SCALE = 100.0
+ACCELERATION_SCALE = 100.0
+ANGULAR_VELOCITY_SCALE = 1000.0
+
+
+def read_frames(stream, poll_interval=None):
+    """
+    Yields (frame_type, payload) for every frame in the binary stream,
+    skipping bytes until the next sync byte if the stream is corrupted
+
+    With a poll interval, (None, None) is yielded whenever no data arrives
+    within it, so the caller can give up on a silent stream
+    """
+    buffer = bytearray()
+    while True:
+        if poll_interval is not None:
+            readable, _, _ = select.select([stream], [], [], poll_interval)
+            if not readable:
+                yield None, None
+                continue
+        chunk = stream.read(4096)
+        if not chunk:
+            return
+        buffer += chunk
+
+        while True:
+            start = buffer.find(FRAME_SYNC)
+            if start < 0:
+                buffer.clear()
+                break
+            del buffer[:start]
+            if len(buffer) < FRAME_HEADER.size:
+                break
+            _, frame_type, length = FRAME_HEADER.unpack_from(buffer)
+            if len(buffer) < FRAME_HEADER.size + length:
+                break
+            yield frame_type, bytes(buffer[FRAME_HEADER.size:FRAME_HEADER.size + length])
+            del buffer[:FRAME_HEADER.size + length]
+
+
+def unpack_quaternion(packed):
+    """
+    Inverse of the smallest-three packing, returns (w, x, y, z)
+    """
+    largest = packed >> 30
+    scale = 511.0 * math.sqrt(2)
+    rest = []
+    for shift in (20, 10, 0):
+        value = (packed >> shift) & 0x3FF
+        if value & 0x200:
+            value -= 0x400
+        rest.append(value / scale)
+    missing = math.sqrt(max(0.0, 1.0 - sum(c * c for c in rest)))
+    rest.insert(largest, missing)
+    return tuple(rest)
+
+
+def _vector(values, scale):
+    return tuple(v / scale for v in values)
+
+
+def decode_compact_sample(stream, data, offset):
+    """
+    Returns (sample dict, new offset) for a single sample of the stream
+    """
+    if stream == telemetry_pb2.TELEMETRY_STREAM_ATTITUDE:
+        packed, wx, wy, wz = struct.unpack_from("<Ihhh", data, offset)
+        sample = {
+            "rotation": unpack_quaternion(packed),
+            "angular_velocity": _vector((wx, wy, wz), ANGULAR_VELOCITY_SCALE),
+        }
+        return sample, offset + 10
+    if stream == telemetry_pb2.TELEMETRY_STREAM_MOTION:
+        values = struct.unpack_from("<iiihhhhhh", data, offset)
+        sample = {
+            "position": _vector(values[0:3], POSITION_SCALE),
+            "velocity": _vector(values[3:6], VELOCITY_SCALE),
+            "acceleration": _vector(values[6:9], ACCELERATION_SCALE),
+        }
+        return sample, offset + 24
+    values = struct.unpack_from("<hhhhhh", data, offset)
+    sample = {
+        "acc": _vector(values[0:3], ACCELERATION_SCALE),
+        "gyro": _vector(values[3:6], ANGULAR_VELOCITY_SCALE),
+    }
+    return sample, offset + 12
+
+
+def decode_compact(payload):
+    """
+    Decodes a compact telemetry frame into a list of
+    (stream, sequence, timestamp in seconds, sample dict)
+    """
+    version, stream, sequence, timestamp_us, period_us, count = TELEMETRY_COMPACT_HEADER.unpack_from(payload)
+    if version != TELEMETRY_COMPACT_VERSION:
+        raise ValueError(f"Unsupported compact telemetry version {version}")
+
+    samples = []
+    offset = TELEMETRY_COMPACT_HEADER.size
+    for i in range(count):
+        sample, offset = decode_compact_sample(stream, payload, offset)
+        samples.append((stream, sequence, (timestamp_us + i * period_us) * 1e-6, sample))
+    return samples
+
+
+def load_log_table(path):
+    """
+    Loads the table generated by tools/log_table.py
+    """
+    with open(path) as table:
+        return {int(k): v["message"] for k, v in json.load(table).items()}
+
+
+def decode_log_binary(payload, table):
+    """
+    Reconstructs the text of a binary log record, see src/util/log_binary.hpp
+    """
+    size, message_id, level = LOG_BINARY_HEADER.unpack_from(payload)
+    offset = LOG_BINARY_HEADER.size
+    args = []
+    while offset < size:
+        arg_format = "<" + LOG_ARG_FORMATS[payload[offset]]
+        args.append(struct.unpack_from(arg_format, payload, offset + 1)[0])
+        offset += 1 + struct.calcsize(arg_format)
+
+    message = table.get(message_id, f"<unknown message {message_id:#010x}>")
+    level_name = LOG_LEVELS[level] if level < len(LOG_LEVELS) else str(level)
+    return f"{level_name}: {message}" + "".join(str(arg) for arg in args)
+
+
+def fnv1a(text):
+    """
+    Id of a parameter from its name, must match src/util/hash.hpp
+    """
+    value = 2166136261
+    for byte in text.encode():
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    """
+    CRC-16/CCITT-FALSE, must match src/util/crc.cpp
+    """
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray()
+    block = bytearray()
+    for byte in data:
+        if byte == 0:
+            out += bytes([len(block) + 1]) + block
+            block.clear()
+        else:
+            block.append(byte)
+            if len(block) == 254:
+                out += b"\xff" + block
+                block.clear()
+    out += bytes([len(block) + 1]) + block
+    return bytes(out)
+
+
+def encode_receiver_frame(frame_type, payload):
+    """
+    Frame sent to the minipilot receiver, see ReceiverFrameType in frame.proto
+    """
+    data = bytes([frame_type]) + payload
+    data += struct.pack("<H", crc16_ccitt(data))
+    return cobs_encode(data) + COBS_DELIMITER
+
+
+def decode_acks(payload):
+    """
+    Yields (sequence, send_time, receive_time_us, apply_time_us, result) of each ack in the frame
+    """
+    for offset in range(0, len(payload) - ACK_RECORD.size + 1, ACK_RECORD.size):
+        yield ACK_RECORD.unpack_from(payload, offset)
+
+RC_CHANNEL_COUNT = 8
+
+
+def encode_rc_frame(sequence, channels):
+    """
+    Stick input frame, channels in range [-1, 1], missing channels are sent as 0
+    """
+    channels = list(channels) + [0.0] * (RC_CHANNEL_COUNT - len(channels))
+    raw = [round(max(-1.0, min(1.0, value)) * 32767) for value in channels[:RC_CHANNEL_COUNT]]
+    payload = struct.pack(f"<H{RC_CHANNEL_COUNT}h", sequence & 0xFFFF, *raw)
+    return encode_receiver_frame(frame_pb2.RECEIVER_FRAME_TYPE_RC, payload)
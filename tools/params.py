@@ -0,0 +1,157 @@
+"""
+Reads and writes the minipilot runtime parameters
+
+Usage:
+    python3 tools/params.py <receiver device> <output device> list
+    python3 tools/params.py <receiver device> <output device> get <name>
+    python3 tools/params.py <receiver device> <output device> set <name> <value>
+    python3 tools/params.py <receiver device> <output device> save
+
+Parameters are addressed by the hash of their name, so get and set work
+without listing first, but set needs the type which is taken from the
+current value. Devices are opened as plain files, so serial ports must be
+configured beforehand.
+"""
+
+import argparse
+import sys
+import time
+
+import mp_frames
+from mp_frames import frame_pb2
+
+import command_pb2
+import param_pb2
+
+# How long to wait for the report or the acknowledgment
+RESPONSE_TIMEOUT = 1.0
+# Longest a read blocks before the timeout is checked
+POLL_INTERVAL = 0.1
+
+
+class ParamClient:
+
+    def __init__(self, receiver, output):
+        self.receiver = receiver
+        self.frames = mp_frames.read_frames(output, POLL_INTERVAL)
+        self.sequence = 0
+
+    def send(self, command):
+        self.sequence += 1
+        command.sequence = self.sequence
+        self.receiver.write(mp_frames.encode_receiver_frame(
+            frame_pb2.RECEIVER_FRAME_TYPE_COMMAND, command.SerializeToString()))
+        return self.sequence
+
+    def wait(self, sequence, want_report):
+        """
+        Wait for the ack of the command and its report if one is expected
+        @returns (result, report), either can be None if not received in time
+        """
+        result = None
+        report = None
+        deadline = time.monotonic() + RESPONSE_TIMEOUT
+        for frame_type, payload in self.frames:
+            # Checked on every poll, also when the link is silent
+            if time.monotonic() > deadline:
+                break
+            if frame_type == frame_pb2.FRAME_TYPE_ACK:
+                for ack in mp_frames.decode_acks(payload):
+                    if ack[0] == sequence:
+                        result = ack[4]
+            elif frame_type == frame_pb2.FRAME_TYPE_PARAM:
+                report = param_pb2.ParamReport()
+                report.ParseFromString(payload)
+            if result is not None and (report is not None or not want_report or result != command_pb2.COMMAND_RESULT_OK):
+                break
+        return result, report
+
+    def get(self, name):
+        command = command_pb2.Command()
+        command.param_get.id = mp_frames.fnv1a(name)
+        result, report = self.wait(self.send(command), True)
+        if result != command_pb2.COMMAND_RESULT_OK or not report or not report.values:
+            return None
+        return report.values[0]
+
+    def set(self, name, text):
+        current = self.get(name)
+        if current is None:
+            return None
+        command = command_pb2.Command()
+        command.param_set.id = current.id
+        if current.type == param_pb2.PARAM_TYPE_FLOAT:
+            command.param_set.float_value = float(text)
+        elif current.type == param_pb2.PARAM_TYPE_INT32:
+            command.param_set.int_value = int(text)
+        else:
+            command.param_set.bool_value = text.lower() in ("1", "true", "on")
+        result, report = self.wait(self.send(command), True)
+        if result != command_pb2.COMMAND_RESULT_OK:
+            return None
+        return report.values[0] if report and report.values else current
+
+    def list(self):
+        values = []
+        while True:
+            command = command_pb2.Command()
+            command.param_list.offset = len(values)
+            result, report = self.wait(self.send(command), True)
+            if result != command_pb2.COMMAND_RESULT_OK or not report or not report.values:
+                break
+            values.extend(report.values)
+            if len(values) >= report.total_count:
+                break
+        return values
+
+    def save(self):
+        command = command_pb2.Command()
+        command.param_save.SetInParent()
+        result, _ = self.wait(self.send(command), False)
+        return result == command_pb2.COMMAND_RESULT_OK
+
+
+def format_value(value):
+    field = value.WhichOneof("value")
+    return f"{value.name} = {getattr(value, field) if field else '?'}"
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("receiver", help="Device connected to the minipilot receiver")
+    parser.add_argument("output", help="Device connected to the minipilot output")
+    parser.add_argument("action", choices=("list", "get", "set", "save"))
+    parser.add_argument("name", nargs="?")
+    parser.add_argument("value", nargs="?")
+    args = parser.parse_args()
+
+    if args.action in ("get", "set") and not args.name or args.action == "set" and args.value is None:
+        parser.error(f"{args.action} needs the parameter name" + (" and value" if args.action == "set" else ""))
+
+    client = ParamClient(open(args.receiver, "wb", buffering=0), open(args.output, "rb", buffering=0))
+
+    if args.action == "list":
+        values = client.list()
+        for value in values:
+            print(format_value(value))
+        ok = bool(values)
+    elif args.action == "get":
+        value = client.get(args.name)
+        if value is not None:
+            print(format_value(value))
+        ok = value is not None
+    elif args.action == "set":
+        value = client.set(args.name, args.value)
+        if value is not None:
+            print(format_value(value))
+        ok = value is not None
+    else:
+        ok = client.save()
+
+    if not ok:
+        print(f"{args.action} failed", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
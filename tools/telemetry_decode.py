@@ -0,0 +1,51 @@
+"""
+Prints the telemetry and logs from a capture of the minipilot output device
+
+Usage: python3 tools/telemetry_decode.py [--log-table <log_table.json>] [capture file]
+(or pipe the data to stdin), the log table is needed for the binary logs
+"""
+
+import argparse
+import sys
+
+from google.protobuf import text_format
+
+import mp_frames
+from mp_frames import frame_pb2, telemetry_pb2
+
+import param_pb2
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--log-table", help="Table generated by tools/log_table.py")
+    parser.add_argument("capture", nargs="?", help="Capture of the output device")
+    args = parser.parse_args()
+
+    stream = open(args.capture, "rb") if args.capture else sys.stdin.buffer
+    log_table = mp_frames.load_log_table(args.log_table) if args.log_table else {}
+
+    for frame_type, payload in mp_frames.read_frames(stream):
+        if frame_type == frame_pb2.FRAME_TYPE_LOG:
+            print(payload.decode(errors="replace"), end="")
+        elif frame_type == frame_pb2.FRAME_TYPE_LOG_BINARY:
+            print(mp_frames.decode_log_binary(payload, log_table))
+        elif frame_type == frame_pb2.FRAME_TYPE_TELEMETRY:
+            msg = telemetry_pb2.TelemetryMessage()
+            msg.ParseFromString(payload)
+            print("telemetry:", text_format.MessageToString(msg, as_one_line=True))
+        elif frame_type == frame_pb2.FRAME_TYPE_ACK:
+            for sequence, send_time, receive_time, apply_time, result in mp_frames.decode_acks(payload):
+                print(f"ack #{sequence}: result {result}, applied {apply_time - receive_time}us after receiving")
+        elif frame_type == frame_pb2.FRAME_TYPE_PARAM:
+            report = param_pb2.ParamReport()
+            report.ParseFromString(payload)
+            print("params:", text_format.MessageToString(report, as_one_line=True))
+        elif frame_type == frame_pb2.FRAME_TYPE_TELEMETRY_COMPACT:
+            for stream_id, sequence, timestamp, sample in mp_frames.decode_compact(payload):
+                name = telemetry_pb2.TelemetryStream.Name(stream_id)
+                print(f"{timestamp:.4f} {name} #{sequence}:", sample)
+
+
+if __name__ == "__main__":
+    main()